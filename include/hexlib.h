@@ -52,9 +52,31 @@ typedef struct {
 
 // Initialization / teardown
 HEXLIB_API int  hl_init(int width, int height, const char* title);
+// hl_init with options. HL_INIT_HEADLESS renders with the software renderer
+// into an offscreen surface (no window, no display or GPU needed, no vsync).
+#define HL_INIT_HEADLESS  (1u << 0)
+#define HL_INIT_SOFTWARE  (1u << 1)  // windowed, but force the software renderer
+#define HL_INIT_NO_VSYNC  (1u << 2)  // present without waiting for vblank
+// HL_INIT_ASYNC_PRESENT moves the window, renderer, event pump and present to
+// a thread owned by hexlib. Only the present is taken off the caller: hl_step
+// still blocks while that thread builds the frame from the live tiles and
+// camera, then returns while the present (and its vsync wait) overlaps the
+// caller's next frame. A build-bound frame is no faster in this mode. Other
+// hexlib calls stay on the caller's thread and may be made at any time; those
+// that touch the renderer wait for the present in flight. Headless-only on
+// macOS. Frame stats report the previous frame's present time.
+#define HL_INIT_ASYNC_PRESENT (1u << 3)
+#define HL_INIT_RENDER_THREAD HL_INIT_ASYNC_PRESENT  // former name
+HEXLIB_API int  hl_init_ex(int width, int height, const char* title, uint32_t flags);
 HEXLIB_API void hl_shutdown(void);
+// Size of the render output (window or offscreen surface) in pixels
+HEXLIB_API void hl_get_output_size(int* out_w, int* out_h);
+// Copy the last presented frame into `pixels` as RGBA32 rows of `pitch`
+// bytes (pitch >= width * 4). Exact in headless mode; with a window it reads
+// the back buffer, which some backends discard on present. Returns 1 on success.
+HEXLIB_API int  hl_read_pixels(void* pixels, int pitch);
 
-// Grid setup (flat_top: 1 = flat-top, 0 = pointy-top; here we’ll use 1)
+// Grid setup (flat_top: 1 = flat-top, 0 = pointy-top)
 HEXLIB_API void hl_set_grid(int rows, int cols, float hex_size, int flat_top);
 
 // Camera (pixel offset + zoom multiplier; zoom > 0)
@@ -65,20 +87,316 @@ HEXLIB_API void hl_set_instances(const HL_HexInstance* instances, int count);
 
 // Manage textured tiles
 HEXLIB_API int  hl_load_texture(int slot, const char* path);
+// Decode on a background loader thread instead; the slot keeps its current
+// texture until the new one is uploaded at the start of a later hl_step.
+// Returns 0 for a bad slot or path (a missing file shows up as a failed load).
+HEXLIB_API int  hl_load_texture_async(int slot, const char* path);
+// 1 = loaded, 0 = async load still in progress, -1 = load failed or slot
+// empty. Polling installs the slot's texture as soon as its decode finishes.
+HEXLIB_API int  hl_texture_ready(int slot);
+// Time hl_step may spend uploading decoded textures (default 2 ms). At least
+// one finished texture is uploaded per frame regardless.
+HEXLIB_API void hl_set_texture_upload_budget(float ms);
 HEXLIB_API void hl_unload_texture(int slot);
 HEXLIB_API void hl_clear_textures(void);
 HEXLIB_API void hl_set_tiles(const HL_TileInstance* tiles, int count);
 HEXLIB_API void hl_clear_tiles(void);
+
+// Zero-copy tile upload. hl_map_tiles returns hexlib-owned storage for at
+// least `capacity` tiles; fill it and publish the first `count` with
+// hl_commit_tiles. The storage is double-buffered: after a commit the next
+// hl_map_tiles returns the other half (holding the tiles from two commits
+// ago), so every committed entry must be rewritten. A mapping stays valid
+// until the next hl_map_tiles / hl_commit_tiles / hl_clear_tiles call.
+// Committing the same coordinates in the same order as the previous commit
+// only invalidates the tiles whose fields changed.
+HEXLIB_API HL_TileInstance* hl_map_tiles(int capacity);
+HEXLIB_API int  hl_commit_tiles(int count);
+
+// Incremental tile updates. Tiles persist across frames keyed by (q, r);
+// field_mask selects which members of each patch are applied. Patches for
+// unknown coordinates insert a new tile (unmasked fields start empty).
+#define HL_TILE_TERRAIN  (1u << 0)  // terrain_tex, terrain_scale
+#define HL_TILE_UNIT     (1u << 1)  // unit_tex, unit_scale
+#define HL_TILE_OVERLAY  (1u << 2)  // overlay
+#define HL_TILE_OFFSET   (1u << 3)  // offset_x, offset_y
+#define HL_TILE_ALL      (HL_TILE_TERRAIN | HL_TILE_UNIT | HL_TILE_OVERLAY | HL_TILE_OFFSET)
+HEXLIB_API int  hl_update_tiles(const HL_TileInstance* patches, int count, uint32_t field_mask);
+// Remove tiles by coordinate; coords holds `count` (q, r) pairs. Returns tiles removed.
+HEXLIB_API int  hl_remove_tiles(const int32_t* coords, int count);
+
+// Binary map files: every tile's terrain, unit and overlay (not offsets)
+// grouped by 8x8 chunk behind an index. hl_load_map replaces the tiles with
+// the file's and maps it read-only; chunks are copied into the tile store as
+// they come into view (or are patched/removed), so opening any size of map
+// is immediate. Past 4096 chunks, chunks that were never edited are dropped
+// again once off screen, oldest first. The file must stay in place until the next hl_load_map,
+// hl_set_tiles, hl_commit_tiles, hl_set_instances or hl_clear_tiles.
+// hl_save_map writes the current tiles. Both return 1 on success.
+HEXLIB_API int  hl_load_map(const char* path);
+HEXLIB_API int  hl_save_map(const char* path);
+
+// Procedural maps. hl_generate_map samples seeded fractal simplex noise
+// (values roughly -1..1) at every hex of a region and gives each hex the
+// terrain of the last band whose threshold is at or below its value (the
+// first band below all thresholds). Rows are spread over the worker pool
+// (hl_set_thread_count); the result does not depend on the thread count.
+#define HL_REGION_HEXAGON   0  // hexes within `radius` of (q0, r0)
+#define HL_REGION_RECTANGLE 1  // axial q0..q0+width-1, r0..r0+height-1, like the path grid
+typedef struct {
+    float    threshold;      // lowest noise value of this band
+    int32_t  terrain_tex;
+    float    terrain_scale;
+    HL_Color overlay;
+} HL_TerrainBand;
+typedef struct {
+    int      shape;          // HL_REGION_*
+    int32_t  q0, r0;
+    int32_t  radius;         // HL_REGION_HEXAGON
+    int32_t  width, height;  // HL_REGION_RECTANGLE
+    uint32_t seed;
+    float    frequency;      // noise cycles per hex at the first octave
+    int      octaves;        // 1..HL_MAX_NOISE_OCTAVES, each twice the frequency at half the weight
+    const HL_TerrainBand* bands;  // ascending thresholds
+    int      band_count;
+} HL_MapGen;
+#define HL_MAX_NOISE_OCTAVES 16
+// Replaces the tiles with the region (no units, no offsets), as
+// hl_commit_tiles does, in row order: r ascending, then q ascending. If
+// out_terrain is not NULL it receives the first max_out hexes' terrain_tex in
+// the same order. Returns the hex count, 0 on bad parameters or no memory.
+HEXLIB_API int  hl_generate_map(const HL_MapGen* gen, int32_t* out_terrain, int max_out);
 HEXLIB_API int  hl_query_texture(int slot, int* out_w, int* out_h);
+// Loaded slots are packed into shared atlas pages as they load. Repacking
+// reclaims space left by unloaded slots; returns the number of pages in use.
+HEXLIB_API int  hl_build_atlas(void);
 HEXLIB_API void hl_set_debug_labels(const HL_DebugLabel* labels, int count);
 
-// Advance a frame: clears, draws, presents. dt_seconds can be 0 if unused.
-HEXLIB_API void hl_step(float dt_seconds);
+// Hex math on arrays of interleaved (q, r) int32 pairs and (x, y) float
+// pairs. Screen positions are output pixels through the current grid,
+// orientation and camera, as drawn by hl_step (hex centers, no tile offsets).
+HEXLIB_API void hl_axial_to_screen_batch(const int32_t* qr, float* xy, int count);
+HEXLIB_API void hl_screen_to_axial_batch(const float* xy, int32_t* qr, int count);
+// out[i] = hex distance from (q, r) to pair i
+HEXLIB_API void hl_hex_distance_batch(int32_t q, int32_t r, const int32_t* qr, int32_t* out, int count);
+// Hexes exactly `radius` steps from (q, r), or within it (center first, then
+// ring by ring), or on the straight line from (q0, r0) to (q1, r1) inclusive.
+// Each writes up to max_out (q, r) pairs and returns the full hex count.
+HEXLIB_API int  hl_ring(int32_t q, int32_t r, int radius, int32_t* out, int max_out);
+HEXLIB_API int  hl_spiral(int32_t q, int32_t r, int radius, int32_t* out, int max_out);
+HEXLIB_API int  hl_line(int32_t q0, int32_t r0, int32_t q1, int32_t r1, int32_t* out, int max_out);
+
+// Pathfinding over a movement-cost grid covering axial q0..q0+width-1,
+// r0..r0+height-1. costs[(r - r0) * width + (q - q0)] is the cost of entering
+// that hex, 0 blocks it; hexes outside the rectangle are blocked. The grid is
+// copied. Passing NULL costs drops it. Returns 0 if out of memory.
+HEXLIB_API int  hl_set_path_grid(int32_t q0, int32_t r0, int width, int height, const uint8_t* costs);
+// Change one hex's entry cost (e.g. a unit moved in or out). Returns 0 if the
+// hex is outside the grid.
+HEXLIB_API int  hl_set_path_cost(int32_t q, int32_t r, uint8_t cost);
+// Hexes whose cheapest path from (q, r) costs at most `budget`, cheapest
+// first, excluding the origin (which may itself be blocked). Writes up to
+// max_out (q, r) pairs to `out` and returns how many hexes are reachable, or
+// 0 if the search ran out of memory.
+HEXLIB_API int  hl_reachable(int32_t q, int32_t r, int budget, int32_t* out, int max_out);
+// Cheapest path from (q0, r0) to (q1, r1) (A*). Writes up to max_out (q, r)
+// pairs to `out`, origin first and destination last, and returns the path
+// length in hexes, or 0 if the destination is blocked or unreachable or the
+// search ran out of memory.
+HEXLIB_API int  hl_find_path(int32_t q0, int32_t r0, int32_t q1, int32_t r1, int32_t* out, int max_out);
+
+// Batch path queries run on a pool of worker threads (plus the caller) with
+// work stealing, each thread using its own scratch over the shared cost grid.
+typedef struct {
+    int32_t q0, r0;   // origin
+    int32_t q1, r1;   // destination
+} HL_PathQuery;
+// lengths[i] receives query i's hl_find_path result. If `coords` is not NULL,
+// query i writes up to max_path (q, r) pairs at coords + i * max_path * 2.
+// Returns how many queries found a path. Don't call other hexlib functions
+// while a batch runs.
+HEXLIB_API int  hl_find_paths_batch(const HL_PathQuery* queries, int count, int32_t* lengths, int32_t* coords, int max_path);
+// Threads used by batch queries, counting the calling thread (1 = run inline,
+// 0 = one per CPU core, the default). Returns the count actually running.
+HEXLIB_API int  hl_set_thread_count(int threads);
+
+// Visibility over an opacity grid covering the same kind of axial rectangle
+// as the path grid: opaque[(r - r0) * width + (q - q0)] nonzero blocks sight,
+// hexes outside the rectangle are opaque. The grid is copied; NULL drops it
+// along with all fog. Re-uploading the same rectangle keeps the fog.
+HEXLIB_API int  hl_set_vision_grid(int32_t q0, int32_t r0, int width, int height, const uint8_t* opaque);
+HEXLIB_API int  hl_set_opaque(int32_t q, int32_t r, uint8_t opaque);
+// 1 if no opaque hex lies strictly between the two hexes on hl_line's line
+HEXLIB_API int  hl_line_of_sight(int32_t q0, int32_t r0, int32_t q1, int32_t r1);
+// Hexes visible from (q, r) within `radius` steps (shadowcasting), nearest
+// ring first. Opaque hexes are visible when any part of them is lit, so
+// walls facing the viewer show. Writes up to max_out (q, r) pairs and
+// returns the full count.
+HEXLIB_API int  hl_fov(int32_t q, int32_t r, int radius, int32_t* out, int max_out);
+
+// Fog of war for up to HL_MAX_FACTIONS factions. hl_update_fog replaces what
+// `faction` sees with the union of its viewers' FOV and adds it to what the
+// faction has explored; viewers are scanned on the worker pool. Returns the
+// number of hexes visible. Call it again after units move or hl_set_opaque.
+#define HL_MAX_FACTIONS 8
+#define HL_FOG_HIDDEN   0  // never seen
+#define HL_FOG_EXPLORED 1  // seen before, not now
+#define HL_FOG_VISIBLE  2
+typedef struct {
+    int32_t q, r;
+    int32_t radius;    // sight range in hexes; negative skips the viewer
+} HL_Viewer;
+HEXLIB_API int  hl_update_fog(int faction, const HL_Viewer* viewers, int count);
+HEXLIB_API void hl_reset_fog(int faction);
+HEXLIB_API int  hl_fog_state(int faction, int32_t q, int32_t r);
+// Draw `faction`'s fog over the tiles: explored hexes tinted `explored`,
+// never-seen hexes (and tiles outside the vision grid) tinted `hidden`.
+// Faction -1 (the default) turns the fog layer off.
+HEXLIB_API void hl_set_fog_view(int faction, HL_Color explored, HL_Color hidden);
+
+// Retained mode: cache the terrain layer (terrain, fallback hexes, overlays)
+// of each 8x8 chunk in a render-target texture and re-render it only when one
+// of its tiles changes. Units and labels stay immediate. Returns 0 if the
+// renderer has no render-target support.
+HEXLIB_API int  hl_set_retained_mode(int enabled);
+
+// Level of detail by on-screen hex radius in pixels. Below flat_size tiles
+// are flat hexes in the average color of their unit or terrain texture (no
+// sprites, outlines or labels); below minimap_size the tile layer is drawn
+// from a minimap texture with one texel per hex. Defaults 6 and 2.5; 0
+// disables a tier. Instances drop their outlines below flat_size.
+HEXLIB_API void hl_set_lod(float flat_size, float minimap_size);
+
+// Tiles are drawn layer by layer: terrain (sprites, fallback hexes and
+// hl_set_instances colors), then overlays, units, fog, then debug labels.
+// Within a layer primitives are grouped by texture and painted top to bottom.
+// Hidden layers are skipped entirely, including in the far-zoom tiers.
+#define HL_LAYER_TERRAIN  (1u << 0)
+#define HL_LAYER_OVERLAYS (1u << 1)
+#define HL_LAYER_UNITS    (1u << 2)
+#define HL_LAYER_LABELS   (1u << 3)
+#define HL_LAYER_FOG      (1u << 4)  // hl_set_fog_view
+#define HL_LAYER_ALL      (HL_LAYER_TERRAIN | HL_LAYER_OVERLAYS | HL_LAYER_UNITS | HL_LAYER_LABELS | HL_LAYER_FOG)
+HEXLIB_API void     hl_set_visible_layers(uint32_t layers);
+HEXLIB_API uint32_t hl_get_visible_layers(void);
+
+// Animation, advanced by hl_step's dt. A terrain animator moves every tile
+// whose terrain is `slot` by offset * sin(speed * t + phase_q * q + phase_r * r)
+// world pixels on top of its own offset, and pulses `tint` over its overlay
+// (0 to tint.a as the wave rises). NULL removes the animator.
+typedef struct {
+    float offset_x, offset_y;  // amplitude in world pixels
+    float speed;               // radians per second
+    float phase_q, phase_r;    // radians per hex step
+    HL_Color tint;             // tint.a = 0 for none
+} HL_TileAnimation;
+HEXLIB_API int hl_set_terrain_animation(int slot, const HL_TileAnimation* anim);
+
+// Move the unit at path[0] to the end of `path` ((q, r) pairs, as written by
+// hl_find_path) and slide its sprite along the path over `seconds`. The unit
+// is stored at the destination at once; if the origin has none but the
+// destination does, only the slide plays. A new move of the same unit
+// replaces its slide. Returns 0 if there is no unit to move.
+#define HL_EASE_LINEAR 0
+#define HL_EASE_IN     1
+#define HL_EASE_OUT    2
+#define HL_EASE_IN_OUT 3
+HEXLIB_API int hl_move_unit(const int32_t* path, int count, float seconds, int easing);
+// Number of unit slides still playing
+HEXLIB_API int hl_active_tweens(void);
+
+// Advance a frame: draws and presents. dt_seconds drives animation; 0
+// freezes it. Returns 1 if a frame was presented, 0 if nothing on screen
+// changed since the last one and the step was skipped.
+HEXLIB_API int  hl_step(float dt_seconds);
+
+// Damage tracking (off by default). hexlib counts scene changes and keeps the
+// frame in a persistent render-target back buffer. hl_step then skips frames
+// with no change (camera, tiles, labels, textures, fog, animation, window
+// events) and redraws only the screen regions around changed chunks, at most
+// HL_MAX_DAMAGE_RECTS of them. Large changes redraw everything. Without
+// render-target support only the idle skip applies. A skipped step returns
+// immediately without a present or vsync wait, so a loop that only calls
+// hl_step spins a core: pace it yourself, e.g. hl_wait_event_timeout after a
+// 0 return. Every drawn frame also pays a full-screen copy from the back
+// buffer to the window, which costs more than it saves on scenes that change
+// most of the screen every frame.
+#define HL_MAX_DAMAGE_RECTS 8
+HEXLIB_API void hl_set_damage_tracking(int enabled);
+
+// Instrumentation for the most recent hl_step. Counters compile to no-ops
+// (and this struct reads back as zeros) when hexlib is built with
+// HEXLIB_STATS=0 (CMake: -DHEXLIB_ENABLE_STATS=OFF).
+//
+// The histogram counts frame intervals (time between consecutive hl_step
+// calls, so app work and vsync waits are included) over the last
+// HL_FRAME_HISTORY frames. Bin i holds intervals below
+// HL_FRAME_HISTOGRAM_EDGES[i] ms and at or above the previous edge; the last
+// bin is open-ended.
+#define HL_FRAME_HISTORY        240
+#define HL_FRAME_HISTOGRAM_BINS 12
+#define HL_FRAME_HISTOGRAM_EDGES { 1.0f, 2.0f, 4.0f, 8.0f, 12.0f, 16.7f, 20.0f, 25.0f, 33.4f, 50.0f, 100.0f, 1e30f }
+typedef struct {
+    uint64_t frame_index;        // hl_step calls since hl_init
+    float    step_ms;            // whole hl_step
+    float    tiles_ms;           // culling + submitting tiles/instances (incl. chunk cache rebuilds)
+    float    labels_ms;          // culling + drawing debug labels
+    float    present_ms;         // SDL_RenderPresent (includes the GPU flush / vsync wait)
+    float    interval_ms;        // time since the previous hl_step started
+    uint32_t hexes_drawn;        // tiles/instances submitted (or composited via a chunk texture)
+    uint32_t hexes_culled;       // tiles/instances rejected by chunk or per-hex culling
+    uint32_t labels_drawn;
+    uint32_t geometry_calls;     // SDL_RenderGeometry submissions
+    uint32_t copy_calls;         // SDL_RenderCopy submissions (retained chunks)
+    uint32_t fill_calls;         // SDL_RenderFillRect submissions (label glyphs without the font texture)
+    uint32_t allocations;        // heap (re)allocations made by hexlib during the frame
+    uint32_t damage_rects;       // screen regions redrawn (0: the step was skipped)
+    uint32_t redrawn_pixels;     // area of those regions
+    uint64_t total_allocations;  // heap (re)allocations since hl_init, frames or not
+    uint64_t bytes_uploaded;     // bytes copied in by hl_set_* / hl_update_tiles since the previous hl_step
+    uint64_t total_bytes_uploaded;
+    uint64_t skipped_frames;     // hl_step calls since hl_init that presented nothing
+    uint32_t histogram[HL_FRAME_HISTOGRAM_BINS];
+} HL_FrameStats;
+HEXLIB_API void hl_get_frame_stats(HL_FrameStats* out);
+
+// Event codes
+#define HL_EVENT_NONE        0
+#define HL_EVENT_QUIT        1
+#define HL_EVENT_LEFT_DOWN   2
+#define HL_EVENT_MOUSE_MOVE  3
+#define HL_EVENT_RIGHT_DOWN  4
+#define HL_EVENT_KEY_DOWN    5  // key repeats are dropped
+#define HL_EVENT_KEY_UP      6
+#define HL_EVENT_MOUSE_UP    7  // any button (hl_poll_events only)
+#define HL_EVENT_WHEEL       8  // hl_poll_events only
+
+#define HL_EVENT_HEX_CHANGED (1u << 0)  // hex differs from the previous mouse event's
+
+typedef struct {
+    int32_t  type;     // HL_EVENT_*
+    int32_t  q, r;     // hex under the cursor (mouse and wheel events)
+    int32_t  x, y;     // cursor position in output pixels
+    int32_t  key;      // SDL_Keycode (key events) or SDL button index (button events)
+    uint16_t mod;      // SDL_Keymod at the time of the event
+    uint16_t flags;    // HL_EVENT_HEX_CHANGED
+    float    wheel_x;  // scroll amount, positive = right / away from the user
+    float    wheel_y;
+} HL_Event;
 
 // Poll input: returns an event code and (if mouse) the hex under cursor.
 // returns: 0=none, 1=quit, 2=mouse_left_down, 3=mouse_move, 4=mouse_right_down,
 //          5=key_down (out_q = SDL_Keycode), 6=key_up (out_q = SDL_Keycode)
 HEXLIB_API int  hl_poll_event(int* out_q, int* out_r);
+// Drain pending input into `out` in one call; returns the number written.
+// Consecutive mouse motion collapses into one event at the latest position,
+// flagged HL_EVENT_HEX_CHANGED if any motion in the run entered a new hex.
+// Events beyond `cap` stay queued for the next call.
+HEXLIB_API int  hl_poll_events(HL_Event* out, int cap);
+// Sleep until an event is queued or timeout_ms passes, without taking it off
+// the queue. Returns 1 if an event is waiting. Lets an idle loop block instead
+// of spinning between skipped hl_step calls.
+HEXLIB_API int  hl_wait_event_timeout(int timeout_ms);
 
 // Helpers available to embedder (optional)
 HEXLIB_API void hl_set_clear_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
@@ -45,10 +45,15 @@ lib.hl_shutdown.argtypes = []
 lib.hl_set_grid.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_float, ctypes.c_int]
 lib.hl_set_instances.argtypes = [ctypes.POINTER(HL_HexInstance), ctypes.c_int]
 lib.hl_step.argtypes = [ctypes.c_float]
+lib.hl_step.restype = ctypes.c_int
+lib.hl_wait_event_timeout.argtypes = [ctypes.c_int]
+lib.hl_wait_event_timeout.restype = ctypes.c_int
 lib.hl_poll_event.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
 lib.hl_poll_event.restype = ctypes.c_int
 lib.hl_set_clear_color.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8]
 
+FRAME_SECONDS = 1.0 / 60.0  # the clear color pulses, so a frame is due every tick
+
 def init():
     ok = lib.hl_init(1280, 800, b"HexLib (Python-controlled)")
     if not ok:
@@ -90,6 +95,7 @@ def main():
     lib.hl_set_instances(arr_type(*batch), len(batch))
 
     while running:
+        frame_start = time.perf_counter()
         # Handle events
         out_q = ctypes.c_int(0)
         out_r = ctypes.c_int(0)
@@ -108,7 +114,11 @@ def main():
         lib.hl_set_clear_color(14, 14, pulse & 0xFF, 255)
 
         lib.hl_step(ctypes.c_float(0.016))
-        time.sleep(0.001)
+        # Skipped frames do not wait on vsync, so sleep out the rest of the
+        # frame unless input arrives first
+        wait_ms = int((FRAME_SECONDS - (time.perf_counter() - frame_start)) * 1000.0)
+        if wait_ms > 0:
+            lib.hl_wait_event_timeout(wait_ms)
 
     lib.hl_shutdown()
 
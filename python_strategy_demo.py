@@ -3,7 +3,6 @@ import math
 import os
 import sys
 import time
-from collections import deque
 
 
 def _load_lib():
@@ -58,6 +57,34 @@ class HL_TileInstance(ctypes.Structure):
                 ("offset_y", ctypes.c_float)]
 
 
+HL_FRAME_HISTOGRAM_BINS = 12
+
+
+class HL_FrameStats(ctypes.Structure):
+    """Mirror of HL_FrameStats: timings and counters for the last hl_step."""
+
+    _fields_ = [("frame_index", ctypes.c_uint64),
+                ("step_ms", ctypes.c_float),
+                ("tiles_ms", ctypes.c_float),
+                ("labels_ms", ctypes.c_float),
+                ("present_ms", ctypes.c_float),
+                ("interval_ms", ctypes.c_float),
+                ("hexes_drawn", ctypes.c_uint32),
+                ("hexes_culled", ctypes.c_uint32),
+                ("labels_drawn", ctypes.c_uint32),
+                ("geometry_calls", ctypes.c_uint32),
+                ("copy_calls", ctypes.c_uint32),
+                ("fill_calls", ctypes.c_uint32),
+                ("allocations", ctypes.c_uint32),
+                ("damage_rects", ctypes.c_uint32),
+                ("redrawn_pixels", ctypes.c_uint32),
+                ("total_allocations", ctypes.c_uint64),
+                ("bytes_uploaded", ctypes.c_uint64),
+                ("total_bytes_uploaded", ctypes.c_uint64),
+                ("skipped_frames", ctypes.c_uint64),
+                ("histogram", ctypes.c_uint32 * HL_FRAME_HISTOGRAM_BINS)]
+
+
 class HL_DebugLabel(ctypes.Structure):
     """Tiny bitmap label (q,r,text) to help debug layout in the renderer."""
 
@@ -66,9 +93,70 @@ class HL_DebugLabel(ctypes.Structure):
                 ("text", ctypes.c_char * 16)]
 
 
+class HL_Event(ctypes.Structure):
+    """One input event from hl_poll_events (mirrors HL_Event in hexlib.h)."""
+
+    _fields_ = [("type", ctypes.c_int32),
+                ("q", ctypes.c_int32),
+                ("r", ctypes.c_int32),
+                ("x", ctypes.c_int32),
+                ("y", ctypes.c_int32),
+                ("key", ctypes.c_int32),       # SDL_Keycode or mouse button
+                ("mod", ctypes.c_uint16),
+                ("flags", ctypes.c_uint16),
+                ("wheel_x", ctypes.c_float),
+                ("wheel_y", ctypes.c_float)]
+
+
+class HL_Viewer(ctypes.Structure):
+    """One unit's eyes for hl_update_fog (mirrors HL_Viewer in hexlib.h)."""
+
+    _fields_ = [("q", ctypes.c_int32),
+                ("r", ctypes.c_int32),
+                ("radius", ctypes.c_int32)]
+
+
+class HL_TileAnimation(ctypes.Structure):
+    """Per-terrain wave animator for hl_set_terrain_animation (mirrors hexlib.h)."""
+
+    _fields_ = [("offset_x", ctypes.c_float),
+                ("offset_y", ctypes.c_float),
+                ("speed", ctypes.c_float),
+                ("phase_q", ctypes.c_float),
+                ("phase_r", ctypes.c_float),
+                ("tint", HL_Color)]
+
+
+class HL_TerrainBand(ctypes.Structure):
+    """Noise range that maps to one terrain for hl_generate_map (mirrors hexlib.h)."""
+
+    _fields_ = [("threshold", ctypes.c_float),
+                ("terrain_tex", ctypes.c_int32),
+                ("terrain_scale", ctypes.c_float),
+                ("overlay", HL_Color)]
+
+
+class HL_MapGen(ctypes.Structure):
+    """Region and noise settings for hl_generate_map (mirrors hexlib.h)."""
+
+    _fields_ = [("shape", ctypes.c_int),
+                ("q0", ctypes.c_int32),
+                ("r0", ctypes.c_int32),
+                ("radius", ctypes.c_int32),
+                ("width", ctypes.c_int32),
+                ("height", ctypes.c_int32),
+                ("seed", ctypes.c_uint32),
+                ("frequency", ctypes.c_float),
+                ("octaves", ctypes.c_int),
+                ("bands", ctypes.POINTER(HL_TerrainBand)),
+                ("band_count", ctypes.c_int)]
+
+
 # Configure lib prototypes so ctypes knows the argument/return layout for each C function.
 lib.hl_init.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_char_p]
 lib.hl_init.restype = ctypes.c_int
+lib.hl_init_ex.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+lib.hl_init_ex.restype = ctypes.c_int
 lib.hl_shutdown.argtypes = []
 lib.hl_set_grid.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_float, ctypes.c_int]
 lib.hl_set_grid.restype = None
@@ -78,22 +166,151 @@ lib.hl_set_tiles.argtypes = [ctypes.POINTER(HL_TileInstance), ctypes.c_int]
 lib.hl_set_tiles.restype = None
 lib.hl_clear_tiles.argtypes = []
 lib.hl_clear_tiles.restype = None
+lib.hl_map_tiles.argtypes = [ctypes.c_int]
+lib.hl_map_tiles.restype = ctypes.c_void_p   # raw address, wrapped with from_address
+lib.hl_commit_tiles.argtypes = [ctypes.c_int]
+lib.hl_commit_tiles.restype = ctypes.c_int
+lib.hl_update_tiles.argtypes = [ctypes.POINTER(HL_TileInstance), ctypes.c_int, ctypes.c_uint32]
+lib.hl_update_tiles.restype = ctypes.c_int
+lib.hl_remove_tiles.argtypes = [ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_remove_tiles.restype = ctypes.c_int
 lib.hl_load_texture.argtypes = [ctypes.c_int, ctypes.c_char_p]
 lib.hl_load_texture.restype = ctypes.c_int
+lib.hl_load_texture_async.argtypes = [ctypes.c_int, ctypes.c_char_p]
+lib.hl_load_texture_async.restype = ctypes.c_int
+lib.hl_texture_ready.argtypes = [ctypes.c_int]
+lib.hl_texture_ready.restype = ctypes.c_int
 lib.hl_unload_texture.argtypes = [ctypes.c_int]
 lib.hl_unload_texture.restype = None
 lib.hl_clear_textures.argtypes = []
 lib.hl_clear_textures.restype = None
+lib.hl_set_retained_mode.argtypes = [ctypes.c_int]
+lib.hl_set_retained_mode.restype = ctypes.c_int
+lib.hl_set_visible_layers.argtypes = [ctypes.c_uint32]
+lib.hl_set_visible_layers.restype = None
+lib.hl_get_visible_layers.argtypes = []
+lib.hl_get_visible_layers.restype = ctypes.c_uint32
 lib.hl_step.argtypes = [ctypes.c_float]
-lib.hl_step.restype = None
+lib.hl_step.restype = ctypes.c_int
+lib.hl_set_damage_tracking.argtypes = [ctypes.c_int]
+lib.hl_set_damage_tracking.restype = None
+lib.hl_wait_event_timeout.argtypes = [ctypes.c_int]
+lib.hl_wait_event_timeout.restype = ctypes.c_int
 lib.hl_poll_event.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
 lib.hl_poll_event.restype = ctypes.c_int
+lib.hl_poll_events.argtypes = [ctypes.POINTER(HL_Event), ctypes.c_int]
+lib.hl_poll_events.restype = ctypes.c_int
 lib.hl_query_texture.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
 lib.hl_query_texture.restype = ctypes.c_int
 lib.hl_set_camera.argtypes = [ctypes.c_float, ctypes.c_float, ctypes.c_float]
 lib.hl_set_camera.restype = None
 lib.hl_set_debug_labels.argtypes = [ctypes.POINTER(HL_DebugLabel), ctypes.c_int]
 lib.hl_set_debug_labels.restype = None
+lib.hl_get_frame_stats.argtypes = [ctypes.POINTER(HL_FrameStats)]
+lib.hl_get_frame_stats.restype = None
+lib.hl_set_path_grid.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int, ctypes.c_int,
+                                 ctypes.POINTER(ctypes.c_uint8)]
+lib.hl_set_path_grid.restype = ctypes.c_int
+lib.hl_set_path_cost.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_uint8]
+lib.hl_set_path_cost.restype = ctypes.c_int
+lib.hl_reachable.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int,
+                             ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_reachable.restype = ctypes.c_int
+lib.hl_find_path.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                             ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_find_path.restype = ctypes.c_int
+lib.hl_set_vision_grid.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int, ctypes.c_int,
+                                   ctypes.POINTER(ctypes.c_uint8)]
+lib.hl_set_vision_grid.restype = ctypes.c_int
+lib.hl_set_opaque.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_uint8]
+lib.hl_set_opaque.restype = ctypes.c_int
+lib.hl_line_of_sight.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32]
+lib.hl_line_of_sight.restype = ctypes.c_int
+lib.hl_fov.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int, ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_fov.restype = ctypes.c_int
+lib.hl_update_fog.argtypes = [ctypes.c_int, ctypes.POINTER(HL_Viewer), ctypes.c_int]
+lib.hl_update_fog.restype = ctypes.c_int
+lib.hl_reset_fog.argtypes = [ctypes.c_int]
+lib.hl_reset_fog.restype = None
+lib.hl_fog_state.argtypes = [ctypes.c_int, ctypes.c_int32, ctypes.c_int32]
+lib.hl_fog_state.restype = ctypes.c_int
+lib.hl_set_fog_view.argtypes = [ctypes.c_int, HL_Color, HL_Color]
+lib.hl_set_fog_view.restype = None
+lib.hl_set_terrain_animation.argtypes = [ctypes.c_int, ctypes.POINTER(HL_TileAnimation)]
+lib.hl_set_terrain_animation.restype = ctypes.c_int
+lib.hl_move_unit.argtypes = [ctypes.POINTER(ctypes.c_int32), ctypes.c_int, ctypes.c_float, ctypes.c_int]
+lib.hl_move_unit.restype = ctypes.c_int
+lib.hl_active_tweens.argtypes = []
+lib.hl_active_tweens.restype = ctypes.c_int
+lib.hl_generate_map.argtypes = [ctypes.POINTER(HL_MapGen), ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_generate_map.restype = ctypes.c_int
+lib.hl_axial_to_screen_batch.argtypes = [ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_float), ctypes.c_int]
+lib.hl_axial_to_screen_batch.restype = None
+lib.hl_screen_to_axial_batch.argtypes = [ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_screen_to_axial_batch.restype = None
+lib.hl_hex_distance_batch.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.POINTER(ctypes.c_int32),
+                                      ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_hex_distance_batch.restype = None
+lib.hl_ring.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int, ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_ring.restype = ctypes.c_int
+lib.hl_spiral.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int, ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_spiral.restype = ctypes.c_int
+lib.hl_line.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+                        ctypes.POINTER(ctypes.c_int32), ctypes.c_int]
+lib.hl_line.restype = ctypes.c_int
+
+
+# hl_init_ex flag: hexlib presents on its own thread, so the present's vsync
+# wait overlaps this script's next frame; hl_step still waits for the build
+# (mirrors hexlib.h).
+HL_INIT_ASYNC_PRESENT = 1 << 3
+
+# Field masks for hl_update_tiles (mirror the HL_TILE_* defines in hexlib.h).
+HL_TILE_TERRAIN = 1 << 0
+HL_TILE_UNIT = 1 << 1
+HL_TILE_OVERLAY = 1 << 2
+HL_TILE_OFFSET = 1 << 3
+HL_TILE_ALL = HL_TILE_TERRAIN | HL_TILE_UNIT | HL_TILE_OVERLAY | HL_TILE_OFFSET
+
+# Event codes and flags (mirror the HL_EVENT_* defines in hexlib.h).
+HL_EVENT_QUIT = 1
+HL_EVENT_LEFT_DOWN = 2
+HL_EVENT_MOUSE_MOVE = 3
+HL_EVENT_RIGHT_DOWN = 4
+HL_EVENT_KEY_DOWN = 5
+HL_EVENT_KEY_UP = 6
+HL_EVENT_WHEEL = 8
+HL_EVENT_HEX_CHANGED = 1 << 0
+EVENT_BATCH = 64
+FRAME_SECONDS = 1.0 / 60.0  # frame budget while the scene is changing
+IDLE_WAIT_MS = 250          # longest sleep once hl_step starts skipping frames
+
+# Draw layers for hl_set_visible_layers (mirror the HL_LAYER_* defines in hexlib.h).
+HL_LAYER_TERRAIN = 1 << 0
+HL_LAYER_OVERLAYS = 1 << 1
+HL_LAYER_UNITS = 1 << 2
+HL_LAYER_LABELS = 1 << 3
+HL_LAYER_FOG = 1 << 4
+
+# Fog of war: the player's faction index and hl_fog_state results.
+PLAYER_FACTION = 0
+HL_FOG_HIDDEN = 0
+HL_FOG_EXPLORED = 1
+HL_FOG_VISIBLE = 2
+
+# Easing curves for hl_move_unit (mirror the HL_EASE_* defines in hexlib.h).
+HL_EASE_LINEAR = 0
+HL_EASE_IN = 1
+HL_EASE_OUT = 2
+HL_EASE_IN_OUT = 3
+UNIT_STEP_SECONDS = 0.12  # slide time per hex when a unit moves
+
+# Map generation for hl_generate_map (region shapes mirror hexlib.h).
+HL_REGION_HEXAGON = 0
+HL_REGION_RECTANGLE = 1
+MAP_SEED = 42
+MAP_NOISE_FREQUENCY = 0.15  # noise cycles per hex; lower gives bigger lakes and ranges
+MAP_NOISE_OCTAVES = 4
 
 
 # Paths and window defaults used throughout the script.
@@ -113,6 +330,7 @@ TERRAIN_DEFS = [
         "overlay": (0, 0, 0, 0),
         "passable": True,
         "scale": 1.0,
+        "elevation": -0.2,             # noise level where this terrain starts (hl_generate_map)
     },
     {
         "name": "water",
@@ -122,6 +340,10 @@ TERRAIN_DEFS = [
         "overlay": (0, 0, 0, 0),
         "passable": False,
         "scale": 1.0,
+        "elevation": -1.0,
+        # Gentle bob animated by hexlib: amplitude in pixels, radians per
+        # second, and phase step per hex along q and r
+        "animation": {"offset_y": 1.3, "speed": 1.0, "phase_q": 0.35, "phase_r": 0.21},
     },
     {
         "name": "mountain",
@@ -130,7 +352,9 @@ TERRAIN_DEFS = [
         "placeholder": (145, 141, 132),
         "overlay": (0, 0, 0, 0),
         "passable": False,
+        "opaque": True,                # blocks line of sight
         "scale": 1.0,
+        "elevation": 0.45,
     },
 ]
 
@@ -143,6 +367,7 @@ UNIT_DEFS = [
         "path": "assets/unit_scout.png",
         "placeholder": (220, 220, 80),
         "move_range": 3,
+        "vision": 4,
         "scale": 0.05,
     }
 ]
@@ -160,6 +385,8 @@ SDLK_MINUS = 45           # '-'
 SDLK_EQUALS = 61          # '='
 SDLK_KP_MINUS = 1073741910
 SDLK_KP_PLUS = 1073741911
+SDLK_F2 = 1073741883      # toggle the coordinate label layer
+SDLK_F3 = 1073741884      # toggle the once-per-second frame stats report
 
 
 def ensure_placeholder_image(path, rgb, size=96):
@@ -242,25 +469,32 @@ def hex_distance(a, b):
 class TerrainType:
     """Runtime wrapper for terrain metadata and texture bookkeeping."""
 
-    def __init__(self, name, slot, rel_path, placeholder_rgb, overlay_rgba, passable, scale):
+    def __init__(self, name, slot, rel_path, placeholder_rgb, overlay_rgba, passable, scale, opaque=False,
+                 animation=None, elevation=0.0):
         self.name = name
         self.slot = slot
         self.rel_path = rel_path
         self.placeholder_rgb = placeholder_rgb
         self.overlay_rgba = overlay_rgba
         self.passable = passable
+        self.opaque = opaque
+        self.animation = animation
+        self.elevation = elevation
         self.loaded = False
         self.scale = scale
         self.pixel_width = 0
         self.pixel_height = 0
 
     def ensure_texture(self):
+        """Queue the texture for a background decode; finish_texture completes it."""
         path = resolve_path(self.rel_path)
         ensure_placeholder_image(path, self.placeholder_rgb)
-        ok = lib.hl_load_texture(self.slot, path.encode("utf-8"))
-        self.loaded = bool(ok)
+        return bool(lib.hl_load_texture_async(self.slot, path.encode("utf-8")))
+
+    def finish_texture(self, ok):
+        self.loaded = ok
         if not self.loaded:
-            print(f"[terrain] Texture load failed for {self.name}: {path}")
+            print(f"[terrain] Texture load failed for {self.name}: {resolve_path(self.rel_path)}")
             return False
         width = ctypes.c_int(0)
         height = ctypes.c_int(0)
@@ -276,22 +510,26 @@ class TerrainType:
 class UnitType:
     """Holds shared data for a given unit archetype (textures, stats)."""
 
-    def __init__(self, name, slot, rel_path, placeholder_rgb, move_range, scale):
+    def __init__(self, name, slot, rel_path, placeholder_rgb, move_range, scale, vision=2):
         self.name = name
         self.slot = slot
         self.rel_path = rel_path
         self.placeholder_rgb = placeholder_rgb
         self.move_range = move_range
+        self.vision = vision
         self.loaded = False
         self.scale = scale
 
     def ensure_texture(self):
+        """Queue the texture for a background decode; finish_texture completes it."""
         path = resolve_path(self.rel_path)
         ensure_placeholder_image(path, self.placeholder_rgb, size=82)
-        ok = lib.hl_load_texture(self.slot, path.encode("utf-8"))
-        self.loaded = bool(ok)
+        return bool(lib.hl_load_texture_async(self.slot, path.encode("utf-8")))
+
+    def finish_texture(self, ok):
+        self.loaded = ok
         if not self.loaded:
-            print(f"[unit] Texture load failed for {self.name}: {path}")
+            print(f"[unit] Texture load failed for {self.name}: {resolve_path(self.rel_path)}")
             return False
         return True
 
@@ -325,6 +563,10 @@ class Unit:
     def move_range(self):
         return self.unit_type.move_range
 
+    @property
+    def vision(self):
+        return self.unit_type.vision
+
     @property
     def texture_slot(self):
         return self.unit_type.slot if self.unit_type.loaded else -1
@@ -350,16 +592,24 @@ class HexStrategyGame:
         self.pan_speed = 320.0  # pixels per second, before zoom scaling
         self.min_zoom = 0.4
         self.max_zoom = 3.5
-        self.time_accum = 0.0
+        self.tiles_uploaded = False   # full upload done; afterwards only changes are sent
+        self.dirty_tiles = set()      # coords whose unit/overlay changed since the last push
+        self.show_stats = False
+        self.stats_timer = 0.0
 
     def initialize(self):
         """Create terrain/unit registries, generate the hex map, prime C renderer."""
         os.makedirs(ASSET_DIR, exist_ok=True)
         self._bootstrap_types()
         self._load_textures()
+        self._register_animations()
         self._configure_hex_size()
         self._build_world()
         self._spawn_units()
+        self._upload_path_grid()
+        self._upload_vision_grid()
+        self._update_fog()
+        lib.hl_set_fog_view(PLAYER_FACTION, make_color(0, 0, 0, 130), make_color(8, 9, 12, 255))
         grid_extent = self.hex_radius * 2 + 1
         rows = cols = grid_extent
         grid_w = (1.5 * (cols - 1) * self.hex_size) + 2.0 * self.hex_size
@@ -382,6 +632,9 @@ class HexStrategyGame:
                 entry["overlay"],
                 entry["passable"],
                 entry.get("scale", 1.0),
+                entry.get("opaque", False),
+                entry.get("animation"),
+                entry.get("elevation", 0.0),
             )
             self.terrain_types[terrain.name] = terrain
         for entry in UNIT_DEFS:
@@ -392,15 +645,43 @@ class HexStrategyGame:
                 entry["placeholder"],
                 entry["move_range"],
                 entry.get("scale", 0.7),
+                entry.get("vision", 2),
             )
             self.unit_types[unit.name] = unit
 
     def _load_textures(self):
-        """Load every referenced texture (and placeholders) into hexlib slots."""
+        """Load every referenced texture (and placeholders) into hexlib slots.
+
+        All files decode in parallel on hexlib's loader threads; this waits
+        until each slot is ready (hex sizing needs the terrain dimensions).
+        """
+        pending = []
+        for kind in (*self.terrain_types.values(), *self.unit_types.values()):
+            if kind.ensure_texture():
+                pending.append(kind)
+            else:
+                kind.finish_texture(False)
+        while pending:
+            waiting = []
+            for kind in pending:
+                state = lib.hl_texture_ready(kind.slot)
+                if state == 0:
+                    waiting.append(kind)
+                else:
+                    kind.finish_texture(state == 1)
+            pending = waiting
+            if pending:
+                time.sleep(0.001)
+
+    def _register_animations(self):
+        """Hand terrain animators to hexlib; hl_step evaluates them from its dt."""
         for terrain in self.terrain_types.values():
-            terrain.ensure_texture()
-        for unit_type in self.unit_types.values():
-            unit_type.ensure_texture()
+            if not terrain.animation:
+                continue
+            anim = HL_TileAnimation()
+            for field, value in terrain.animation.items():
+                setattr(anim, field, value)
+            lib.hl_set_terrain_animation(terrain.slot, ctypes.byref(anim))
 
     def _configure_hex_size(self):
         """Set hex_size based on grass art so tiles align tightly."""
@@ -423,10 +704,25 @@ class HexStrategyGame:
             ctypes.c_float(self.camera_zoom),
         )
 
-    def update(self, dt):
-        """Advance any time-based animation counters."""
-        if dt > 0.0:
-            self.time_accum += dt
+    def report_stats(self, dt):
+        """Print hexlib's frame stats once per second while F3 is toggled on."""
+        if not self.show_stats:
+            return
+        self.stats_timer += dt
+        if self.stats_timer < 1.0:
+            return
+        self.stats_timer = 0.0
+        stats = HL_FrameStats()
+        lib.hl_get_frame_stats(ctypes.byref(stats))
+        print("frame %d: step %.2fms (tiles %.2f, labels %.2f, present %.2f) "
+              "hexes %d drawn / %d culled, %d geometry + %d copy + %d fill calls, "
+              "%d damage rects (%d px), %d skipped, "
+              "%d allocs, %d bytes in, histogram %s" % (
+                  stats.frame_index, stats.step_ms, stats.tiles_ms, stats.labels_ms,
+                  stats.present_ms, stats.hexes_drawn, stats.hexes_culled,
+                  stats.geometry_calls, stats.copy_calls, stats.fill_calls,
+                  stats.damage_rects, stats.redrawn_pixels, stats.skipped_frames,
+                  stats.allocations, stats.bytes_uploaded, list(stats.histogram)))
 
     def update_camera(self, dt):
         """Apply WASD movement to the camera and clamp zoom range."""
@@ -447,43 +743,36 @@ class HexStrategyGame:
         self.sync_camera()
 
     def _build_world(self):
-        """Populate self.tiles with terrain based on simple heuristics."""
-        rng = random_from_seed(42)
+        """Populate self.tiles from hexlib's noise generator (deterministic per MAP_SEED)."""
         radius = self.hex_radius
-        grass = self.terrain_types["grass"]
-        water = self.terrain_types["water"]
-        mountain = self.terrain_types["mountain"]
-
-        for q in range(-radius, radius + 1):
-            r_min = max(-radius, -q - radius)
-            r_max = min(radius, -q + radius)
-            for r in range(r_min, r_max + 1):
-                terrain = self._pick_terrain(q, r, radius, rng, grass, water, mountain)
-                tile = Tile(q, r, terrain)
-                self.tiles[(q, r)] = tile
+        terrains = sorted(self.terrain_types.values(), key=lambda t: t.elevation)
+        bands = (HL_TerrainBand * len(terrains))()
+        for band, terrain in zip(bands, terrains):
+            band.threshold = terrain.elevation
+            band.terrain_tex = terrain.slot
+            band.terrain_scale = terrain.scale
+            band.overlay = terrain.base_overlay()
+        gen = HL_MapGen(shape=HL_REGION_HEXAGON, q0=0, r0=0, radius=radius, seed=MAP_SEED,
+                        frequency=MAP_NOISE_FREQUENCY, octaves=MAP_NOISE_OCTAVES,
+                        bands=bands, band_count=len(terrains))
+        capacity = 3 * radius * (radius + 1) + 1
+        slots = (ctypes.c_int32 * capacity)()
+        count = lib.hl_generate_map(ctypes.byref(gen), slots, capacity)
+        by_slot = {t.slot: t for t in terrains}
+
+        # hl_generate_map writes row by row: r ascending, then q ascending
+        i = 0
+        for r in range(-radius, radius + 1):
+            for q in range(max(-radius, -r - radius), min(radius, -r + radius) + 1):
+                if i < count:
+                    self.tiles[(q, r)] = Tile(q, r, by_slot[slots[i]])
+                i += 1
 
         # Ensure starting area stays passable
-        if (0, 0) in self.tiles:
-            self.tiles[(0, 0)].terrain = grass
-        if (1, -1) in self.tiles:
-            self.tiles[(1, -1)].terrain = grass
-        if (0, -1) in self.tiles:
-            self.tiles[(0, -1)].terrain = grass
-
-    def _pick_terrain(self, q, r, radius, rng, grass, water, mountain):
-        """Very simple terrain generator that biases edges to mountains/water."""
-        if r <= -3:
-            return water
-        if q + r > radius - 1:
-            return mountain
-        if abs(q) <= 1 and abs(r) <= 1:
-            return grass
-        roll = rng()
-        if roll < 0.12:
-            return water
-        if roll < 0.22:
-            return mountain
-        return grass
+        grass = self.terrain_types["grass"]
+        for coord in ((0, 0), (1, -1), (0, -1)):
+            if coord in self.tiles:
+                self.tiles[coord].terrain = grass
 
     def _spawn_units(self):
         """Drop initial units onto the map (currently just a single scout)."""
@@ -492,20 +781,41 @@ class HexStrategyGame:
         self.units.append(unit)
         self.tiles[(0, 0)].unit = unit
 
-    def handle_event(self, ev, q, r):
-        """Route events coming from C to Python helpers."""
-        if ev == 1:
+    def handle_event(self, ev):
+        """Route an HL_Event coming from C to Python helpers."""
+        # Motion within the same hex cannot change the hover highlight.
+        if ev.type == HL_EVENT_MOUSE_MOVE and not ev.flags & HL_EVENT_HEX_CHANGED:
+            return
+        before = self._highlighted()
+        self._dispatch_event(ev)
+        # Overlay colours only change where highlighting appeared or vanished.
+        self.dirty_tiles |= before ^ self._highlighted()
+
+    def _highlighted(self):
+        """Coords that currently carry a selection/reachable/hover overlay."""
+        coords = set(self.reachable)
+        if self.selected_unit:
+            coords.add((self.selected_unit.q, self.selected_unit.r))
+        if self.hover_hex:
+            coords.add(self.hover_hex)
+        return coords
+
+    def _dispatch_event(self, ev):
+        kind = ev.type
+        if kind == HL_EVENT_QUIT:
             self.running = False
-        elif ev == 2:
-            self._handle_left_click(q, r)
-        elif ev == 4:
-            self._handle_right_click(q, r)
-        elif ev == 3:
-            self._handle_hover(q, r)
-        elif ev == 5:
-            self._handle_key_down(q)
-        elif ev == 6:
-            self._handle_key_up(q)
+        elif kind == HL_EVENT_LEFT_DOWN:
+            self._handle_left_click(ev.q, ev.r)
+        elif kind == HL_EVENT_RIGHT_DOWN:
+            self._handle_right_click(ev.q, ev.r)
+        elif kind == HL_EVENT_MOUSE_MOVE:
+            self._handle_hover(ev.q, ev.r)
+        elif kind == HL_EVENT_KEY_DOWN:
+            self._handle_key_down(ev.key)
+        elif kind == HL_EVENT_KEY_UP:
+            self._handle_key_up(ev.key)
+        elif kind == HL_EVENT_WHEEL:
+            self.camera_zoom *= 1.1 ** ev.wheel_y
 
     def _handle_left_click(self, q, r):
         tile = self.tiles.get((q, r))
@@ -544,6 +854,10 @@ class HexStrategyGame:
             self.camera_zoom *= 0.9
         elif key in (SDLK_EQUALS, SDLK_KP_PLUS):
             self.camera_zoom *= 1.1
+        elif key == SDLK_F2:
+            lib.hl_set_visible_layers(lib.hl_get_visible_layers() ^ HL_LAYER_LABELS)
+        elif key == SDLK_F3:
+            self.show_stats = not self.show_stats
 
     def _handle_key_up(self, key):
         self.keys_down.discard(key)
@@ -551,68 +865,81 @@ class HexStrategyGame:
     def _move_unit(self, unit, target_tile):
         """Relocate a unit and recompute its reachable tiles."""
         origin_tile = self.tiles[(unit.q, unit.r)]
+        # hexlib moves the sprite itself and slides it along the path
+        path = (ctypes.c_int32 * (2 * len(self.tiles)))()
+        steps = lib.hl_find_path(unit.q, unit.r, target_tile.q, target_tile.r, path, len(self.tiles))
+        if steps < 2:
+            path[0], path[1], path[2], path[3] = unit.q, unit.r, target_tile.q, target_tile.r
+            steps = 2
+        lib.hl_move_unit(path, steps, ctypes.c_float(UNIT_STEP_SECONDS * (steps - 1)), HL_EASE_IN_OUT)
         origin_tile.unit = None
+        self.dirty_tiles.add((origin_tile.q, origin_tile.r))
+        self.dirty_tiles.add((target_tile.q, target_tile.r))
         unit.q, unit.r = target_tile.q, target_tile.r
         target_tile.unit = unit
+        # Occupied tiles block other units; keep hexlib's cost grid in step.
+        lib.hl_set_path_cost(origin_tile.q, origin_tile.r, self._path_cost(origin_tile))
+        lib.hl_set_path_cost(target_tile.q, target_tile.r, self._path_cost(target_tile))
         self.reachable = self._compute_reachable(unit)
+        self._update_fog()
+
+    def _path_cost(self, tile):
+        """Cost of entering a tile for hexlib's pathfinder (0 = blocked)."""
+        return 1 if tile.terrain.passable and tile.unit is None else 0
+
+    def _upload_path_grid(self):
+        """Send the movement-cost grid (the map's bounding rhombus) to hexlib once."""
+        radius = self.hex_radius
+        size = radius * 2 + 1
+        costs = (ctypes.c_uint8 * (size * size))()  # hexes outside the map stay 0
+        for (q, r), tile in self.tiles.items():
+            costs[(r + radius) * size + (q + radius)] = self._path_cost(tile)
+        lib.hl_set_path_grid(-radius, -radius, size, size, costs)
+
+    def _upload_vision_grid(self):
+        """Send which hexes block sight (same rhombus as the path grid) to hexlib once."""
+        radius = self.hex_radius
+        size = radius * 2 + 1
+        opaque = (ctypes.c_uint8 * (size * size))()
+        for (q, r), tile in self.tiles.items():
+            opaque[(r + radius) * size + (q + radius)] = 1 if tile.terrain.opaque else 0
+        lib.hl_set_vision_grid(-radius, -radius, size, size, opaque)
+
+    def _update_fog(self):
+        """Recompute what the player's units see; hexlib draws the fog in hl_step."""
+        viewers = (HL_Viewer * max(1, len(self.units)))()
+        for i, unit in enumerate(self.units):
+            viewers[i].q, viewers[i].r, viewers[i].radius = unit.q, unit.r, unit.vision
+        lib.hl_update_fog(PLAYER_FACTION, viewers, len(self.units))
 
     def _compute_reachable(self, unit):
-        """Breadth-first search for all tiles reachable within move_range."""
-        origin = (unit.q, unit.r)
-        max_steps = unit.move_range
-        visited = {origin}
-        reachable = set()
-        frontier = deque()
-        frontier.append((origin, 0))
-        while frontier:
-            (cq, cr), dist = frontier.popleft()
-            for nq, nr in axial_neighbors(cq, cr):
-                if (nq, nr) in visited:
-                    continue
-                tile = self.tiles.get((nq, nr))
-                if not tile:
-                    continue
-                if dist + 1 > max_steps:
-                    continue
-                if not tile.passable_for(unit):
-                    continue
-                visited.add((nq, nr))
-                reachable.add((nq, nr))
-                frontier.append(((nq, nr), dist + 1))  # enqueue for further exploration
-        return reachable
+        """All tiles reachable within move_range, searched natively by hexlib."""
+        capacity = len(self.tiles)
+        out = (ctypes.c_int32 * (capacity * 2))()
+        count = lib.hl_reachable(unit.q, unit.r, unit.move_range, out, capacity)
+        return {(out[i * 2], out[i * 2 + 1]) for i in range(min(count, capacity))}
 
     def push_tiles(self):
-        """Construct HL_TileInstance and debug label arrays for hexlib."""
-        instances = []
+        """Send tile state to hexlib: everything once, then only what changed."""
+        if not self.tiles_uploaded:
+            self._upload_all_tiles()
+            return
+        if self.dirty_tiles:
+            patches = [self._tile_instance(self.tiles[c]) for c in self.dirty_tiles if c in self.tiles]
+            self.dirty_tiles.clear()
+            if patches:
+                arr_type = HL_TileInstance * len(patches)
+                lib.hl_update_tiles(arr_type(*patches), len(patches), HL_TILE_UNIT | HL_TILE_OVERLAY)
+
+    def _upload_all_tiles(self):
+        """Write every tile straight into hexlib's mapped buffer and build the label array."""
+        count = len(self.tiles)
+        address = lib.hl_map_tiles(count) if count else None
+        mapped = (HL_TileInstance * count).from_address(address) if address else None
         labels = []
-        tile_index = 0  # keeps iteration count if we need deterministic patterns later
-        for (q, r), tile in self.tiles.items():
-            terrain_slot = tile.terrain.slot if tile.terrain.loaded else -1
-            unit_slot = tile.unit.texture_slot if tile.unit else -1
-            terrain_scale = float(tile.terrain.scale if tile.terrain else 1.0)
-            unit_scale = float(tile.unit.unit_type.scale if tile.unit else 1.0)
-            overlay = self._overlay_for_tile(tile)
-
-            # Optional wobble/padding to help visualise offset behaviour.
-            offset_x = 0.0
-            offset_y = 0.0
-            if tile.terrain.name == "water":
-                offset_y = math.sin(self.time_accum + q * 0.35 + r * 0.21) * 1.3
-            elif (q + r) % 4 == 0:
-                offset_x = 0.0  # tweak this to slide every 4th tile horizontally
-
-            # Fill out the ctypes struct explicitly so every field is obvious.
-            inst = HL_TileInstance()
-            inst.q = q
-            inst.r = r
-            inst.terrain_tex = terrain_slot
-            inst.unit_tex = unit_slot
-            inst.terrain_scale = terrain_scale
-            inst.unit_scale = unit_scale
-            inst.overlay = overlay
-            inst.offset_x = offset_x
-            inst.offset_y = offset_y
-            instances.append(inst)
+        for i, ((q, r), tile) in enumerate(self.tiles.items()):
+            if mapped is not None:
+                self._tile_instance(tile, mapped[i])
 
             # Emit debug labels for tiles aligned on the 5-grid (helps spot drift).
             if q % 5 == 0 or r % 5 == 0:
@@ -622,19 +949,52 @@ class HexStrategyGame:
                 label_struct.r = r
                 label_struct.text = (label_text + b"\0" * 16)[:16]
                 labels.append(label_struct)
-            tile_index += 1
-        if not instances:
+        self.tiles_uploaded = True
+        self.dirty_tiles.clear()
+        if mapped is None:
             lib.hl_clear_tiles()
             lib.hl_set_debug_labels(None, 0)
             return
-        arr_type = HL_TileInstance * len(instances)
-        lib.hl_set_tiles(arr_type(*instances), len(instances))
+        # The mapping is only valid until this commit; drop our view of it.
+        del mapped
+        lib.hl_commit_tiles(count)
         if labels:
             label_arr_type = HL_DebugLabel * len(labels)
             lib.hl_set_debug_labels(label_arr_type(*labels), len(labels))
         else:
             lib.hl_set_debug_labels(None, 0)
 
+    def _tile_instance(self, tile, inst=None):
+        """Fill out the ctypes struct for one tile explicitly so every field is obvious.
+
+        Pass `inst` to write into an existing struct (e.g. an element of the
+        hl_map_tiles buffer) instead of allocating a new one.
+        """
+        q, r = tile.q, tile.r
+        terrain_slot = tile.terrain.slot if tile.terrain.loaded else -1
+        unit_slot = tile.unit.texture_slot if tile.unit else -1
+        terrain_scale = float(tile.terrain.scale if tile.terrain else 1.0)
+        unit_scale = float(tile.unit.unit_type.scale if tile.unit else 1.0)
+
+        # Static per-tile nudges; water's bob is a hexlib terrain animator.
+        offset_x = 0.0
+        offset_y = 0.0
+        if (q + r) % 4 == 0:
+            offset_x = 0.0  # tweak this to slide every 4th tile horizontally
+
+        if inst is None:
+            inst = HL_TileInstance()
+        inst.q = q
+        inst.r = r
+        inst.terrain_tex = terrain_slot
+        inst.unit_tex = unit_slot
+        inst.terrain_scale = terrain_scale
+        inst.unit_scale = unit_scale
+        inst.overlay = self._overlay_for_tile(tile)
+        inst.offset_x = offset_x
+        inst.offset_y = offset_y
+        return inst
+
     def _overlay_for_tile(self, tile):
         """Compute per-tile overlay colour (selection, reachable, hover)."""
         base = tile.terrain.base_overlay()
@@ -648,49 +1008,49 @@ class HexStrategyGame:
         return base
 
 
-def random_from_seed(seed):
-    """Simple LCG-based RNG so world generation is deterministic."""
-    state = seed
-
-    def _rnd():
-        nonlocal state
-        state = (1103515245 * state + 12345) & 0x7FFFFFFF
-        return (state % 1000) / 1000.0
-
-    return _rnd
-
-
 def main():
     """Entry point: initialise hexlib, run the main loop, tear down cleanly."""
-    if not lib.hl_init(WINDOW_WIDTH, WINDOW_HEIGHT, b"Hex Strategy Demo"):
+    # macOS only creates windows on the main thread, so render there
+    flags = 0 if sys.platform == "darwin" else HL_INIT_ASYNC_PRESENT
+    if not lib.hl_init_ex(WINDOW_WIDTH, WINDOW_HEIGHT, b"Hex Strategy Demo", flags):
         raise RuntimeError("Failed to initialize SDL2/hexlib")
+    # Cache static terrain per chunk; falls back to immediate drawing if unsupported.
+    lib.hl_set_retained_mode(1)
+    # Skip unchanged frames; the loop below waits for input after a skipped step
+    lib.hl_set_damage_tracking(1)
 
     game = HexStrategyGame()
     game.initialize()
 
+    events = (HL_Event * EVENT_BATCH)()
     last_time = time.perf_counter()
 
     try:
         while game.running:
-            # Drain all pending input events before simulating the next frame.
+            # Drain all pending input in one call (mouse motion arrives coalesced).
             while True:
-                out_q = ctypes.c_int(0)
-                out_r = ctypes.c_int(0)
-                ev = lib.hl_poll_event(ctypes.byref(out_q), ctypes.byref(out_r))
-                if ev == 0:
+                count = lib.hl_poll_events(events, EVENT_BATCH)
+                for i in range(count):
+                    game.handle_event(events[i])
+                if count < EVENT_BATCH:
                     break
-                game.handle_event(ev, out_q.value, out_r.value)
 
             now = time.perf_counter()
             dt = now - last_time
             last_time = now
 
-            game.update(dt)
             game.update_camera(dt)
             game.push_tiles()
-            lib.hl_step(ctypes.c_float(dt))
-            # Tiny sleep to keep CPU usage sane while still targeting ~60 FPS.
-            time.sleep(0.004)
+            drawn = lib.hl_step(ctypes.c_float(dt))
+            game.report_stats(dt)
+            # Sleep until input arrives or the next frame is due. hexlib skips
+            # frames where nothing changed, so an idle scene can wait longer.
+            if drawn or game.keys_down:
+                wait_ms = int((FRAME_SECONDS - (time.perf_counter() - now)) * 1000.0)
+            else:
+                wait_ms = IDLE_WAIT_MS
+            if wait_ms > 0:
+                lib.hl_wait_event_timeout(wait_ms)
     finally:
         lib.hl_shutdown()
 
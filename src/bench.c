@@ -0,0 +1,422 @@
+#define SDL_MAIN_HANDLED
+#include "../include/hexlib.h"
+#include <SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// hex_bench: deterministic rendering scenarios for tracking hexlib
+// regressions. Every scenario runs headless (software renderer, no vsync)
+// unless --windowed is given and prints one JSON document to stdout.
+// --async-present runs it with HL_INIT_ASYNC_PRESENT, so frame times cover
+// only the build and not the present. Damage tracking is off so every frame
+// is drawn in full; --damage-tracking leaves it on, and the static scenes
+// then time skipped frames. Phase timings and hex counts read zero when
+// hexlib is built without stats. The paths scenario renders nothing: it
+// times batch path queries at each --threads count.
+
+#define BENCH_WIDTH   1280
+#define BENCH_HEIGHT  720
+#define BENCH_HEX     24.0f
+#define BENCH_WARMUP  10
+#define BENCH_PATH_ROUNDS 10   // batches timed per thread count
+#define BENCH_PATH_RANGE  12   // destinations lie within this many hexes (q and r) of the origin
+
+typedef enum {
+    SCENE_INSTANCES,  // color-only instances
+    SCENE_TILES,      // textured tiles, overlays and units
+    SCENE_LABELS,     // color instances with a label on every hex
+    SCENE_SWEEP,      // textured tiles under a camera pan/zoom sweep
+    SCENE_PATHS,      // hl_find_paths_batch scaling across thread counts (no rendering)
+    SCENE_OVERVIEW,   // textured tiles with the whole map on screen (LOD tiers)
+    SCENE_COUNT
+} SceneKind;
+
+static const char* scene_names[SCENE_COUNT] = { "instances", "tiles", "labels", "sweep", "paths", "overview" };
+static const int   default_sizes[] = { 1000, 10000, 100000, 1000000 };
+
+typedef struct {
+    double   p50_ms, p99_ms, mean_ms, max_ms;
+    double   setup_ms;
+    double   geometry_calls, copy_calls, fill_calls;  // mean per frame
+    uint32_t max_draw_calls;
+    double   allocations;                             // mean per frame
+    double   tiles_ms, labels_ms, present_ms;         // mean per frame
+    double   hexes_drawn, hexes_culled;               // mean per frame
+    uint32_t max_allocations;
+    uint64_t setup_allocations;
+} BenchResult;
+
+// xorshift32: same sequence on every platform, unlike rand()
+static uint32_t bench_rand(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double ms_since(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+    int i = (int)ceil(p * count) - 1;
+    if (i < 0) i = 0;
+    if (i >= count) i = count - 1;
+    return sorted[i];
+}
+
+// Hexes fill a side x side rectangle in odd-q layout; hex i maps to (q, r)
+static void bench_coord(int i, int side, int32_t* q, int32_t* r) {
+    *q = i % side;
+    *r = i / side - *q / 2;
+}
+
+static int load_textures(const char* assets) {
+    static const char* files[] = { "terrain_grass.png", "terrain_mountain.png", "terrain_water.png", "unit_scout.png" };
+    int loaded = 0;
+    char path[1024];
+    for (int i = 0; i < 4; ++i) {
+        snprintf(path, sizeof(path), "%s/%s", assets, files[i]);
+        loaded += hl_load_texture(i, path);
+    }
+    return loaded;
+}
+
+static void upload_scene(SceneKind kind, int count, int side, uint32_t seed) {
+    uint32_t rng = seed;
+    if (kind == SCENE_TILES || kind == SCENE_SWEEP || kind == SCENE_OVERVIEW) {
+        HL_TileInstance* tiles = (HL_TileInstance*)calloc((size_t)count, sizeof(HL_TileInstance));
+        if (!tiles) return;
+        for (int i = 0; i < count; ++i) {
+            HL_TileInstance* t = &tiles[i];
+            bench_coord(i, side, &t->q, &t->r);
+            uint32_t v = bench_rand(&rng);
+            t->terrain_tex = (int32_t)(v % 3);
+            t->unit_tex = (v % 17 == 0) ? 3 : -1;
+            t->terrain_scale = 1.0f;
+            t->unit_scale = 0.7f;
+            if (v % 5 == 0) {
+                t->overlay.r = 255; t->overlay.g = 220; t->overlay.b = 120; t->overlay.a = 60;
+            }
+        }
+        hl_set_tiles(tiles, count);
+        free(tiles);
+        return;
+    }
+
+    HL_HexInstance* inst = (HL_HexInstance*)malloc(sizeof(HL_HexInstance) * (size_t)count);
+    if (!inst) return;
+    for (int i = 0; i < count; ++i) {
+        bench_coord(i, side, &inst[i].q, &inst[i].r);
+        uint32_t v = bench_rand(&rng);
+        inst[i].color.r = (uint8_t)(40 + (v & 127));
+        inst[i].color.g = (uint8_t)(80 + ((v >> 8) & 127));
+        inst[i].color.b = (uint8_t)(120 + ((v >> 16) & 127));
+        inst[i].color.a = 255;
+    }
+    hl_set_instances(inst, count);
+    free(inst);
+
+    if (kind == SCENE_LABELS) {
+        HL_DebugLabel* labels = (HL_DebugLabel*)malloc(sizeof(HL_DebugLabel) * (size_t)count);
+        if (!labels) return;
+        for (int i = 0; i < count; ++i) {
+            bench_coord(i, side, &labels[i].q, &labels[i].r);
+            // Format wide enough for any two ints, then clip to the label field
+            char text[24];
+            snprintf(text, sizeof(text), "%d,%d", labels[i].q, labels[i].r);
+            size_t len = strlen(text);
+            if (len >= sizeof(labels[i].text)) len = sizeof(labels[i].text) - 1;
+            memcpy(labels[i].text, text, len);
+            labels[i].text[len] = '\0';
+        }
+        hl_set_debug_labels(labels, count);
+        free(labels);
+    }
+}
+
+// Camera for frame `f`: static scenes look at the map center at zoom 1, the
+// sweep pans corner to corner while zooming between 0.2 and 1.5, the overview
+// zooms out until the whole map fits (down to the 0.05 camera minimum).
+static void bench_camera(SceneKind kind, int side, int f, int frames) {
+    float world_w = 1.5f * BENCH_HEX * side;
+    float world_h = sqrtf(3.0f) * BENCH_HEX * side;
+    // hl_set_grid centers maps that fit the window and anchors larger ones at its center
+    float cx = world_w > BENCH_WIDTH ? -world_w * 0.5f : 0.0f;
+    float cy = world_h > BENCH_HEIGHT ? -world_h * 0.5f : 0.0f;
+    if (kind == SCENE_OVERVIEW) {
+        float zoom = fminf(BENCH_WIDTH / world_w, BENCH_HEIGHT / world_h);
+        hl_set_camera(cx, cy, fminf(zoom, 1.0f));
+        return;
+    }
+    if (kind != SCENE_SWEEP) {
+        hl_set_camera(cx, cy, 1.0f);
+        return;
+    }
+    float t = frames > 1 ? (float)f / (float)(frames - 1) : 0.0f;
+    float zoom = 0.2f + 1.3f * (0.5f - 0.5f * cosf(t * 4.0f * 3.14159265f));
+    hl_set_camera(cx + world_w * (0.5f - t), cy + world_h * (0.5f - t), zoom);
+}
+
+static int run_scene(SceneKind kind, int count, int frames, const char* assets, uint32_t flags, int damage, BenchResult* out) {
+    if (!hl_init_ex(BENCH_WIDTH, BENCH_HEIGHT, "hex_bench", flags)) return 0;
+    hl_set_damage_tracking(damage);
+    int side = (int)ceil(sqrt((double)count));
+    hl_set_grid(side, side, BENCH_HEX, 1);
+    if (kind == SCENE_TILES || kind == SCENE_SWEEP || kind == SCENE_OVERVIEW) load_textures(assets);
+
+    HL_FrameStats stats;
+    hl_get_frame_stats(&stats);
+    uint64_t allocs_before = stats.total_allocations;
+    Uint64 start = SDL_GetPerformanceCounter();
+    upload_scene(kind, count, side, 0x9E3779B9u ^ (uint32_t)count ^ ((uint32_t)kind << 24));
+    out->setup_ms = ms_since(start);
+    hl_get_frame_stats(&stats);
+    out->setup_allocations = stats.total_allocations - allocs_before;
+
+    double* times = (double*)malloc(sizeof(double) * (size_t)frames);
+    if (!times) {
+        hl_shutdown();
+        return 0;
+    }
+    double geometry = 0.0, copies = 0.0, fills = 0.0, allocs = 0.0;
+    double tiles_ms = 0.0, labels_ms = 0.0, present_ms = 0.0, drawn = 0.0, culled = 0.0;
+    out->max_draw_calls = 0;
+    out->max_allocations = 0;
+    for (int f = -BENCH_WARMUP; f < frames; ++f) {
+        bench_camera(kind, side, f < 0 ? 0 : f, frames);
+        start = SDL_GetPerformanceCounter();
+        hl_step(0.0f);
+        double ms = ms_since(start);
+        if (f < 0) continue;
+        times[f] = ms;
+        hl_get_frame_stats(&stats);
+        uint32_t draws = stats.geometry_calls + stats.copy_calls + stats.fill_calls;
+        geometry += stats.geometry_calls;
+        copies += stats.copy_calls;
+        fills += stats.fill_calls;
+        allocs += stats.allocations;
+        tiles_ms += stats.tiles_ms;
+        labels_ms += stats.labels_ms;
+        present_ms += stats.present_ms;
+        drawn += stats.hexes_drawn;
+        culled += stats.hexes_culled;
+        if (draws > out->max_draw_calls) out->max_draw_calls = draws;
+        if (stats.allocations > out->max_allocations) out->max_allocations = stats.allocations;
+    }
+    hl_shutdown();
+
+    double total = 0.0;
+    for (int f = 0; f < frames; ++f) total += times[f];
+    qsort(times, (size_t)frames, sizeof(double), compare_double);
+    out->p50_ms = percentile(times, frames, 0.50);
+    out->p99_ms = percentile(times, frames, 0.99);
+    out->max_ms = times[frames - 1];
+    out->mean_ms = total / frames;
+    out->geometry_calls = geometry / frames;
+    out->copy_calls = copies / frames;
+    out->fill_calls = fills / frames;
+    out->allocations = allocs / frames;
+    out->tiles_ms = tiles_ms / frames;
+    out->labels_ms = labels_ms / frames;
+    out->present_ms = present_ms / frames;
+    out->hexes_drawn = drawn / frames;
+    out->hexes_culled = culled / frames;
+    free(times);
+    return 1;
+}
+
+// One path query per ~100 hexes (AI units scale with the map), 256..10000
+static int path_query_count(int count) {
+    int n = count / 100;
+    if (n < 256) n = 256;
+    if (n > 10000) n = 10000;
+    return n;
+}
+
+// Time hl_find_paths_batch over a side x side cost grid at each thread count
+// and print one result per count. Speedup is relative to the first count.
+static int run_paths(int count, const int* threads, int thread_count, int* first) {
+    int side = (int)ceil(sqrt((double)count));
+    int queries = path_query_count(count);
+    uint32_t rng = 0x9E3779B9u ^ (uint32_t)count;
+    uint8_t* costs = (uint8_t*)malloc((size_t)side * side);
+    HL_PathQuery* batch = (HL_PathQuery*)malloc(sizeof(HL_PathQuery) * (size_t)queries);
+    int32_t* lengths = (int32_t*)malloc(sizeof(int32_t) * (size_t)queries);
+    if (!costs || !batch || !lengths) {
+        free(costs);
+        free(batch);
+        free(lengths);
+        return 0;
+    }
+    // 15% blocked, the rest costs 1..3
+    for (int i = 0; i < side * side; ++i) {
+        uint32_t v = bench_rand(&rng);
+        costs[i] = (v % 100 < 15) ? 0 : (uint8_t)(1 + (v >> 8) % 3);
+    }
+    int span = BENCH_PATH_RANGE * 2 + 1;
+    for (int i = 0; i < queries; ++i) {
+        HL_PathQuery* q = &batch[i];
+        q->q0 = (int32_t)(bench_rand(&rng) % (uint32_t)side);
+        q->r0 = (int32_t)(bench_rand(&rng) % (uint32_t)side);
+        q->q1 = q->q0 + (int32_t)(bench_rand(&rng) % (uint32_t)span) - BENCH_PATH_RANGE;
+        q->r1 = q->r0 + (int32_t)(bench_rand(&rng) % (uint32_t)span) - BENCH_PATH_RANGE;
+    }
+    hl_set_path_grid(0, 0, side, side, costs);
+
+    double base_ms = 0.0;
+    for (int t = 0; t < thread_count; ++t) {
+        int running = hl_set_thread_count(threads[t]);
+        int found = hl_find_paths_batch(batch, queries, lengths, NULL, 0);  // warm the scratch
+        double times[BENCH_PATH_ROUNDS];
+        double total = 0.0;
+        for (int k = 0; k < BENCH_PATH_ROUNDS; ++k) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            hl_find_paths_batch(batch, queries, lengths, NULL, 0);
+            times[k] = ms_since(start);
+            total += times[k];
+        }
+        qsort(times, BENCH_PATH_ROUNDS, sizeof(double), compare_double);
+        double mean = total / BENCH_PATH_ROUNDS;
+        if (t == 0) base_ms = mean;
+        printf("%s\n    {\"scene\": \"paths\", \"hexes\": %d, \"threads\": %d, \"queries\": %d, \"found\": %d,\n"
+               "     \"batch_ms\": {\"p50\": %.4f, \"mean\": %.4f, \"max\": %.4f},\n"
+               "     \"us_per_query\": %.3f, \"speedup\": %.2f}",
+               *first ? "" : ",", count, running, queries, found,
+               percentile(times, BENCH_PATH_ROUNDS, 0.50), mean, times[BENCH_PATH_ROUNDS - 1],
+               mean * 1000.0 / queries, mean > 0.0 ? base_ms / mean : 0.0);
+        fflush(stdout);
+        *first = 0;
+    }
+    hl_shutdown();  // drops the grid and stops the workers
+    free(costs);
+    free(batch);
+    free(lengths);
+    return 1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [--scene instances|tiles|labels|sweep|paths|overview|all] [--sizes 1000,10000,...]\n"
+        "          [--frames N] [--assets DIR] [--windowed] [--async-present] [--damage-tracking]\n"
+        "          [--threads 1,2,4,...]\n", prog);
+}
+
+int main(int argc, char** argv) {
+    int scene = -1;  // all
+    int sizes[16];
+    int size_count = 0;
+    int threads[16];
+    int thread_count = 0;
+    int frames = 120;
+    int windowed = 0;
+    int async_present = 0;
+    int damage = 0;
+    const char* assets = "assets";
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--scene") == 0 && val) {
+            ++i;
+            if (strcmp(val, "all") == 0) continue;
+            for (int k = 0; k < SCENE_COUNT; ++k) {
+                if (strcmp(val, scene_names[k]) == 0) scene = k;
+            }
+            if (scene < 0) { usage(argv[0]); return 1; }
+        } else if (strcmp(arg, "--sizes") == 0 && val) {
+            ++i;
+            for (const char* p = val; *p && size_count < 16;) {
+                int n = atoi(p);
+                if (n > 0) sizes[size_count++] = n;
+                p = strchr(p, ',');
+                if (!p) break;
+                ++p;
+            }
+        } else if (strcmp(arg, "--threads") == 0 && val) {
+            ++i;
+            for (const char* p = val; *p && thread_count < 16;) {
+                int n = atoi(p);
+                if (n > 0) threads[thread_count++] = n;
+                p = strchr(p, ',');
+                if (!p) break;
+                ++p;
+            }
+        } else if (strcmp(arg, "--frames") == 0 && val) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--assets") == 0 && val) {
+            assets = argv[++i];
+        } else if (strcmp(arg, "--windowed") == 0) {
+            windowed = 1;
+        } else if (strcmp(arg, "--async-present") == 0) {
+            async_present = 1;
+        } else if (strcmp(arg, "--damage-tracking") == 0) {
+            damage = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+    if (size_count == 0) {
+        size_count = (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+        memcpy(sizes, default_sizes, sizeof(default_sizes));
+    }
+    if (thread_count == 0) {
+        // 1, 2, 4, ... up to the core count, which is always included
+        int cores = SDL_GetCPUCount();
+        for (int n = 1; n < cores && thread_count < 15; n *= 2) threads[thread_count++] = n;
+        threads[thread_count++] = cores > 1 ? cores : 1;
+    }
+
+    uint32_t flags = windowed ? HL_INIT_NO_VSYNC : HL_INIT_HEADLESS;
+    if (async_present) flags |= HL_INIT_ASYNC_PRESENT;
+    printf("{\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"mode\": \"%s\",\n  \"async_present\": %s,\n"
+           "  \"damage_tracking\": %s,\n  \"results\": [",
+           frames, BENCH_WARMUP, windowed ? "windowed" : "headless", async_present ? "true" : "false",
+           damage ? "true" : "false");
+    int first = 1;
+    for (int k = 0; k < SCENE_COUNT; ++k) {
+        if (scene >= 0 && k != scene) continue;
+        for (int s = 0; s < size_count; ++s) {
+            if (k == SCENE_PATHS) {
+                if (!run_paths(sizes[s], threads, thread_count, &first)) {
+                    fprintf(stderr, "hex_bench: paths/%d out of memory\n", sizes[s]);
+                    return 1;
+                }
+                continue;
+            }
+            BenchResult r;
+            memset(&r, 0, sizeof(r));
+            if (!run_scene((SceneKind)k, sizes[s], frames, assets, flags, damage, &r)) {
+                fprintf(stderr, "hex_bench: %s/%d failed to initialize\n", scene_names[k], sizes[s]);
+                return 1;
+            }
+            printf("%s\n    {\"scene\": \"%s\", \"hexes\": %d, \"setup_ms\": %.3f, \"setup_allocations\": %llu,\n"
+                   "     \"frame_ms\": {\"p50\": %.4f, \"p99\": %.4f, \"mean\": %.4f, \"max\": %.4f},\n"
+                   "     \"phase_ms\": {\"tiles\": %.4f, \"labels\": %.4f, \"present\": %.4f},\n"
+                   "     \"hex_counts\": {\"drawn\": %.1f, \"culled\": %.1f},\n"
+                   "     \"draw_calls\": {\"geometry\": %.2f, \"copy\": %.2f, \"fill\": %.2f, \"max\": %u},\n"
+                   "     \"allocations\": {\"mean\": %.2f, \"max\": %u}}",
+                   first ? "" : ",", scene_names[k], sizes[s], r.setup_ms, (unsigned long long)r.setup_allocations,
+                   r.p50_ms, r.p99_ms, r.mean_ms, r.max_ms,
+                   r.tiles_ms, r.labels_ms, r.present_ms,
+                   r.hexes_drawn, r.hexes_culled,
+                   r.geometry_calls, r.copy_calls, r.fill_calls, r.max_draw_calls,
+                   r.allocations, r.max_allocations);
+            fflush(stdout);
+            first = 0;
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -1,11 +1,37 @@
 #define SDL_DISABLE_IMMINTRIN_H 1
 #include <SDL.h>
 #include <SDL_image.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "../include/hexlib.h"
 
+// SSE2 is baseline on x86-64; the AVX2 kernel is compiled for its own target
+// and only picked when SDL_HasAVX2() says so. Define HEXLIB_NO_SIMD to build
+// the scalar paths only.
+#if !defined(HEXLIB_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define HL_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define HL_SIMD_AVX2 1
+#define HL_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define HL_SIMD_AVX2 1
+#define HL_TARGET_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 typedef struct {
     int rows, cols;
     float size;          // hex radius (flat-top: horizontal radius)
@@ -16,15 +42,22 @@ typedef struct {
 
 static SDL_Window*     g_window = NULL;
 static SDL_Renderer*   g_renderer = NULL;
+static SDL_Surface*    g_offscreen = NULL;  // headless render target (no window)
+static int             g_output_w = 0, g_output_h = 0;  // refreshed on SDL_WINDOWEVENT_SIZE_CHANGED
 static HL_Grid         g_grid = {0};
 static HL_HexInstance* g_instances = NULL;
 static int             g_instance_count = 0;
+static int             g_instance_cap = 0;
 static SDL_Color       g_clear = { 12, 12, 16, 255 }; // default dark
 
 typedef struct {
-    SDL_Texture* texture;
+    SDL_Texture* texture;  // atlas page holding the image, or the slot's own texture
     int w;
     int h;
+    SDL_Surface* surface;  // RGBA32 copy of the pixels, kept so the atlas can be repacked
+    int page;              // atlas page index, -1 = standalone texture owned by the slot
+    float u0, v0, u1, v1;  // normalized sub-rect inside `texture`
+    SDL_Color average;     // alpha-weighted mean color, for the zoomed-out LOD tiers
 } HL_TextureSlot;
 
 static HL_TextureSlot  g_textures[HL_MAX_TEXTURE_SLOTS] = {0};
@@ -35,22 +68,207 @@ static float           g_camera_offset_y = 0.0f;
 static float           g_camera_zoom = 1.0f;
 static HL_DebugLabel*  g_labels = NULL;
 static int             g_label_count = 0;
+static int             g_label_cap = 0;
+static float           g_tile_max_scale = 1.0f;   // largest terrain/unit scale in g_tiles
+static float           g_tile_max_offset = 0.0f;  // largest |offset_x|/|offset_y| in g_tiles
+
+// --- Frame stats ---
+// Counters behind hl_get_frame_stats. Building with HEXLIB_STATS=0 turns every
+// HL_STAT_* site into a no-op so release builds pay nothing for them.
+#ifndef HEXLIB_STATS
+#define HEXLIB_STATS 1
+#endif
+
+#if HEXLIB_STATS
+#define HL_STAT_ADD(field, n) (g_stats.field += (n))
+#define HL_STAT_NOW()         SDL_GetPerformanceCounter()
+#else
+#define HL_STAT_ADD(field, n) ((void)0)
+#define HL_STAT_NOW()         ((Uint64)0)
+#endif
+
+static HL_FrameStats g_stats = {0};
+static uint64_t      g_upload_mark = 0;                    // total_bytes_uploaded at the last hl_step
+static Uint64        g_last_step = 0;                      // counter value when the last hl_step began
+static int           g_frame_ring_pos = 0;
+static int           g_frame_ring_count = 0;
+
+// All heap traffic goes through these so allocations show up in the stats
+static void* heap_malloc(size_t size) {
+    HL_STAT_ADD(allocations, 1);
+    HL_STAT_ADD(total_allocations, 1);
+    return malloc(size);
+}
+
+static void* heap_calloc(size_t count, size_t size) {
+    HL_STAT_ADD(allocations, 1);
+    HL_STAT_ADD(total_allocations, 1);
+    return calloc(count, size);
+}
+
+static void* heap_realloc(void* ptr, size_t size) {
+    HL_STAT_ADD(allocations, 1);
+    HL_STAT_ADD(total_allocations, 1);
+    return realloc(ptr, size);
+}
+
+static void stats_reset(void) {
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_upload_mark = 0;
+    g_last_step = 0;
+    g_frame_ring_pos = 0;
+    g_frame_ring_count = 0;
+}
+
+#if HEXLIB_STATS
+static uint8_t g_frame_bins[HL_FRAME_HISTORY];  // histogram bin of each recent frame (ring)
+
+static float stats_ms(Uint64 from, Uint64 to) {
+    return (float)((double)(to - from) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+#endif
+
+// Reset the per-frame counters and push the interval since the previous
+// hl_step into the rolling histogram
+static void stats_begin_frame(Uint64 now) {
+#if HEXLIB_STATS
+    static const float edges[HL_FRAME_HISTOGRAM_BINS] = HL_FRAME_HISTOGRAM_EDGES;
+    g_stats.frame_index++;
+    g_stats.hexes_drawn = 0;
+    g_stats.hexes_culled = 0;
+    g_stats.labels_drawn = 0;
+    g_stats.geometry_calls = 0;
+    g_stats.copy_calls = 0;
+    g_stats.fill_calls = 0;
+    g_stats.allocations = 0;
+    g_stats.damage_rects = 0;
+    g_stats.redrawn_pixels = 0;
+    g_stats.bytes_uploaded = g_stats.total_bytes_uploaded - g_upload_mark;
+    g_upload_mark = g_stats.total_bytes_uploaded;
+    g_stats.interval_ms = 0.0f;
+    if (g_last_step != 0) {
+        float ms = stats_ms(g_last_step, now);
+        int bin = 0;
+        while (bin < HL_FRAME_HISTOGRAM_BINS - 1 && ms >= edges[bin]) bin++;
+        if (g_frame_ring_count == HL_FRAME_HISTORY) {
+            g_stats.histogram[g_frame_bins[g_frame_ring_pos]]--;
+        } else {
+            g_frame_ring_count++;
+        }
+        g_frame_bins[g_frame_ring_pos] = (uint8_t)bin;
+        g_stats.histogram[bin]++;
+        g_frame_ring_pos = (g_frame_ring_pos + 1) % HL_FRAME_HISTORY;
+        g_stats.interval_ms = ms;
+    }
+    g_last_step = now;
+#else
+    (void)now;
+#endif
+}
+
+static void stats_end_frame(Uint64 start, Uint64 tiles, Uint64 labels, Uint64 present, Uint64 end) {
+#if HEXLIB_STATS
+    g_stats.tiles_ms = stats_ms(tiles, labels);
+    g_stats.labels_ms = stats_ms(labels, present);
+    g_stats.present_ms = stats_ms(present, end);
+    g_stats.step_ms = stats_ms(start, end);
+#else
+    (void)start; (void)tiles; (void)labels; (void)present; (void)end;
+#endif
+}
+
+// --- Scene damage ---
+// Every change that shows on screen bumps g_scene_gen and either damages the
+// whole frame or names the tile-index chunks it touched. hl_step skips frames
+// while the generation matches the last one drawn and otherwise redraws only
+// the screen around the damaged chunks (see frame_damage_rects).
+#define HL_MAX_DAMAGE_CHUNKS 256
+
+static int      g_damage_tracking = 0;
+static uint32_t g_scene_gen = 1;       // bumped by every visible change
+static uint32_t g_scene_drawn = 0;     // generation of the last frame drawn
+static int      g_damage_all = 1;      // next frame redraws everything
+static int32_t  g_damage_chunks[HL_MAX_DAMAGE_CHUNKS * 2];  // (cq, cr) pairs
+static int      g_damage_chunk_count = 0;
+
+static void scene_damage_all(void) {
+    g_scene_gen++;
+    g_damage_all = 1;
+}
+
+// Damage chunk (cq, cr); past HL_MAX_DAMAGE_CHUNKS the whole frame instead
+static void scene_damage_chunk(int32_t cq, int32_t cr) {
+    g_scene_gen++;
+    if (g_damage_all) return;
+    for (int k = g_damage_chunk_count - 1; k >= 0; --k) {
+        if (g_damage_chunks[2 * k] == cq && g_damage_chunks[2 * k + 1] == cr) return;
+    }
+    if (g_damage_chunk_count == HL_MAX_DAMAGE_CHUNKS) {
+        g_damage_all = 1;
+        return;
+    }
+    g_damage_chunks[2 * g_damage_chunk_count] = cq;
+    g_damage_chunks[2 * g_damage_chunk_count + 1] = cr;
+    g_damage_chunk_count++;
+}
+
+// The frame on screen now matches the scene
+static void scene_damage_clear(void) {
+    g_scene_drawn = g_scene_gen;
+    g_damage_all = 0;
+    g_damage_chunk_count = 0;
+}
+
+// Damaged regions are redrawn into this target, which keeps every other pixel
+// from the frames before, then copied to the output for the present
+static SDL_Texture* g_backbuffer = NULL;
+static int          g_backbuffer_w = 0, g_backbuffer_h = 0;  // size it was made for, even if that failed
+static int          g_backbuffer_valid = 0;                  // holds a complete frame
+
+static void backbuffer_free(void) {
+    if (g_backbuffer) SDL_DestroyTexture(g_backbuffer);
+    g_backbuffer = NULL;
+    g_backbuffer_w = g_backbuffer_h = 0;
+    g_backbuffer_valid = 0;
+}
 
-// --- Math for axial coords (flat-top) ---
+// --- Math for axial coords ---
 // Reference: https://www.redblobgames.com/grids/hex-grids/
-static void axial_to_pixel_flat(int q, int r, float size, float* outx, float* outy) {
-    // flat-top axial to pixel
-    float x = size * (3.0f/2.0f * q);
-    float y = size * (sqrtf(3.0f)/2.0f * q + sqrtf(3.0f) * r);
-    *outx = x + g_grid.origin_x;
-    *outy = y + g_grid.origin_y;
+#define HL_SQRT3 1.7320508f
+
+// Axial <-> pixel as a 2x2 matrix per orientation (in units of hex size)
+typedef struct {
+    float f0, f1, f2, f3;  // x = f0*q + f1*r, y = f2*q + f3*r
+    float b0, b1, b2, b3;  // q = b0*x + b1*y, r = b2*x + b3*y
+} HL_Orientation;
+
+static const HL_Orientation g_orient_flat = {
+    1.5f, 0.0f, HL_SQRT3 * 0.5f, HL_SQRT3,
+    2.0f / 3.0f, 0.0f, -1.0f / 3.0f, HL_SQRT3 / 3.0f,
+};
+static const HL_Orientation g_orient_pointy = {
+    HL_SQRT3, HL_SQRT3 * 0.5f, 0.0f, 1.5f,
+    HL_SQRT3 / 3.0f, -1.0f / 3.0f, 0.0f, 2.0f / 3.0f,
+};
+static const HL_Orientation* g_orient = &g_orient_flat;  // follows g_grid.flat_top
+
+static void axial_to_pixel(int q, int r, float size, float* outx, float* outy) {
+    *outx = size * (g_orient->f0 * q + g_orient->f1 * r) + g_grid.origin_x;
+    *outy = size * (g_orient->f2 * q + g_orient->f3 * r) + g_grid.origin_y;
+}
+
+// Bounding box of a hex of radius `size`
+static void hex_bounds(float size, float* w, float* h) {
+    *w = g_grid.flat_top ? 2.0f * size : HL_SQRT3 * size;
+    *h = g_grid.flat_top ? HL_SQRT3 * size : 2.0f * size;
 }
 
-// Inverse (pixel to axial, flat-top), rounded to nearest hex
+// Round fractional cube coords to the nearest hex. Ties round to even, the
+// same as the SIMD kernels.
 static void cube_round(float x, float y, float z, int* rq, int* rr) {
-    int rx = (int)lroundf(x);
-    int ry = (int)lroundf(y);
-    int rz = (int)lroundf(z);
+    int rx = (int)lrintf(x);
+    int ry = (int)lrintf(y);
+    int rz = (int)lrintf(z);
 
     float x_diff = fabsf(rx - x);
     float y_diff = fabsf(ry - y);
@@ -68,475 +286,5630 @@ static void cube_round(float x, float y, float z, int* rq, int* rr) {
     *rr = rz;
 }
 
-static void pixel_to_axial_flat(float px, float py, float size, int* outq, int* outr) {
-    float x = px - g_grid.origin_x;
-    float y = py - g_grid.origin_y;
-    // Inverse of axial_to_pixel (flat-top)
-    float qf = (2.0f/3.0f) * x / size;
-    float rf = (-1.0f/3.0f) * x / size + (1.0f/sqrtf(3.0f)) * y / size;
-
-    // Convert axial (qf, rf) to cube
-    float xf = qf;
-    float zf = rf;
-    float yf = -xf - zf;
-    int rq, rr;
-    cube_round(xf, yf, zf, &rq, &rr);
-    *outq = rq;
-    *outr = rr;
+// Hex `i` of the `steps` + 1 hexes on the line from (q0, r0) to (q1, r1).
+// The endpoints are nudged so samples never land exactly on a hex edge.
+static void hex_line_at(int32_t q0, int32_t r0, int32_t q1, int32_t r1, int i, int steps, int* q, int* r) {
+    float aq = q0 + 1e-6f, ar = r0 + 2e-6f;
+    float bq = q1 + 1e-6f, br = r1 + 2e-6f;
+    float t = steps > 0 ? (float)i / (float)steps : 0.0f;
+    float qf = aq + (bq - aq) * t, rf = ar + (br - ar) * t;
+    cube_round(qf, -qf - rf, rf, q, r);
 }
 
-static void hex_corners_flat(float cx, float cy, float size, SDL_FPoint out[6]) {
-    // flat-top: angles start at 0°, step 60°
-    for (int i = 0; i < 6; ++i) {
-        float angle = (float)M_PI / 180.0f * (60.0f * i);
-        out[i].x = cx + size * cosf(angle);
-        out[i].y = cy + size * sinf(angle);
-    }
+// Inverse of axial_to_pixel, rounded to nearest hex
+static void pixel_to_axial(float px, float py, float size, int* outq, int* outr) {
+    float x = (px - g_grid.origin_x) / size;
+    float y = (py - g_grid.origin_y) / size;
+    float qf = g_orient->b0 * x + g_orient->b1 * y;
+    float rf = g_orient->b2 * x + g_orient->b3 * y;
+    cube_round(qf, -qf - rf, rf, outq, outr);
 }
 
-static void screen_to_world(float* px, float* py) {
-    int w = 0, h = 0;
-    SDL_GetWindowSize(g_window, &w, &h);
-    float zoom = g_camera_zoom;
-    if (zoom < 0.05f) zoom = 0.05f;
-    float x = *px;
-    float y = *py;
-    x = (x - w * 0.5f) / zoom + w * 0.5f;
-    y = (y - h * 0.5f) / zoom + h * 0.5f;
-    x -= g_camera_offset_x;
-    y -= g_camera_offset_y;
-    *px = x;
-    *py = y;
-}
+// --- Worker pool ---
+// Batch APIs split their items between the calling thread and up to
+// HL_MAX_THREADS - 1 workers. Each participant starts with an even share of
+// the items and claims short runs from its front; once its share is empty it
+// steals the back half of another, so a few expensive items (long paths)
+// don't leave the rest of the pool idle. Participant 0 is the calling thread.
+// Jobs run concurrently and must not touch hexlib state other than their own
+// per-thread scratch.
+#define HL_MAX_THREADS 64
+#define HL_POOL_GRAIN  4   // items claimed from the own share at a time
 
-static void world_to_screen(float* px, float* py, int win_w, int win_h) {
-    float zoom = g_camera_zoom;
-    if (zoom < 0.05f) zoom = 0.05f;
-    float x = *px + g_camera_offset_x;
-    float y = *py + g_camera_offset_y;
-    x = (x - win_w * 0.5f) * zoom + win_w * 0.5f;
-    y = (y - win_h * 0.5f) * zoom + win_h * 0.5f;
-    *px = x;
-    *py = y;
-}
+typedef void (*HL_PoolFn)(void* ctx, int index, int thread);
 
 typedef struct {
-    uint8_t rows[5];
-} Glyph3x5;
+    SDL_SpinLock lock;
+    int          begin, end;  // unclaimed items of this share
+    char         pad[64 - sizeof(SDL_SpinLock) - 2 * sizeof(int)];  // one share per cache line
+} HL_PoolShare;
 
-static const Glyph3x5 glyph_digits[10] = {
-    {{0b111,0b101,0b101,0b101,0b111}}, // 0
-    {{0b010,0b110,0b010,0b010,0b111}}, // 1
-    {{0b111,0b001,0b111,0b100,0b111}}, // 2
-    {{0b111,0b001,0b111,0b001,0b111}}, // 3
-    {{0b101,0b101,0b111,0b001,0b001}}, // 4
-    {{0b111,0b100,0b111,0b001,0b111}}, // 5
-    {{0b111,0b100,0b111,0b101,0b111}}, // 6
-    {{0b111,0b001,0b010,0b010,0b010}}, // 7
-    {{0b111,0b101,0b111,0b101,0b111}}, // 8
-    {{0b111,0b101,0b111,0b001,0b111}}, // 9
-};
-static const Glyph3x5 glyph_minus = { {0b000,0b000,0b111,0b000,0b000} };
-static const Glyph3x5 glyph_comma = { {0b000,0b000,0b000,0b010,0b100} };
+static SDL_Thread*  g_pool_threads[HL_MAX_THREADS];
+static int          g_pool_size = 0;        // participants incl. the caller; 0 = not started
+static int          g_pool_wanted = 0;      // hl_set_thread_count; 0 = one per CPU core
+static SDL_sem*     g_pool_start = NULL;    // one post per worker per job
+static SDL_sem*     g_pool_done = NULL;     // one post per worker that finished the job
+static int          g_pool_quit = 0;        // read by workers after a start post
+static HL_PoolShare g_pool_shares[HL_MAX_THREADS];
+static HL_PoolFn    g_pool_fn = NULL;
+static void*        g_pool_ctx = NULL;
 
-static const Glyph3x5* glyph_for_char(char c) {
-    if (c >= '0' && c <= '9') return &glyph_digits[c - '0'];
-    if (c == '-') return &glyph_minus;
-    if (c == ',') return &glyph_comma;
-    return NULL;
-}
+// Claim the next run of items for `thread`. Returns its length (0 when no
+// share has anything left) and the first item in *first.
+static int pool_claim(int thread, int* first) {
+    HL_PoolShare* own = &g_pool_shares[thread];
+    for (;;) {
+        SDL_AtomicLock(&own->lock);
+        int n = own->end - own->begin;
+        if (n > HL_POOL_GRAIN) n = HL_POOL_GRAIN;
+        *first = own->begin;
+        own->begin += n;
+        SDL_AtomicUnlock(&own->lock);
+        if (n > 0) return n;
 
-static void draw_glyph(SDL_Renderer* renderer, float x, float y, float scale, const Glyph3x5* glyph) {
-    if (!glyph) return;
-    for (int row = 0; row < 5; ++row) {
-        uint8_t bits = glyph->rows[row];
-        for (int col = 0; col < 3; ++col) {
-            if (bits & (1 << (2 - col))) {
-                SDL_FRect rect = { x + col * scale, y + row * scale, scale, scale };
-                SDL_RenderFillRectF(renderer, &rect);
-            }
+        int stolen = 0;
+        for (int k = 1; k < g_pool_size && !stolen; ++k) {
+            HL_PoolShare* victim = &g_pool_shares[(thread + k) % g_pool_size];
+            SDL_AtomicLock(&victim->lock);
+            int left = victim->end - victim->begin;
+            int take = (left + 1) / 2;
+            int from = victim->end - take;
+            victim->end = from;
+            SDL_AtomicUnlock(&victim->lock);
+            if (take <= 0) continue;
+            SDL_AtomicLock(&own->lock);
+            own->begin = from;
+            own->end = from + take;
+            SDL_AtomicUnlock(&own->lock);
+            stolen = 1;
         }
+        if (!stolen) return 0;
     }
 }
 
-static void draw_label(SDL_Renderer* renderer, float cx, float cy, const char* text, float base_scale) {
-    if (!text || !*text) return;
-    size_t len = strlen(text);
-    if (len == 0) return;
-    float char_w = 3.0f * base_scale;
-    float spacing = base_scale;
-    float text_w = len * char_w + (len - 1) * spacing;
-    float text_h = 5.0f * base_scale;
-    float x = cx - text_w * 0.5f;
-    float y = cy - text_h * 0.5f;
-    SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
-    for (size_t i = 0; i < len; ++i) {
-        const Glyph3x5* glyph = glyph_for_char(text[i]);
-        if (glyph) {
-            draw_glyph(renderer, x, y, base_scale, glyph);
-            x += char_w + spacing;
-        } else {
-            x += char_w + spacing;
-        }
+static void pool_work(int thread) {
+    int first, n;
+    while ((n = pool_claim(thread, &first)) > 0) {
+        for (int i = first; i < first + n; ++i) g_pool_fn(g_pool_ctx, i, thread);
     }
 }
-HEXLIB_API int hl_init(int width, int height, const char* title) {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
-        SDL_Log("SDL_Init failed: %s", SDL_GetError());
-        return 0;
-    }
-    // SDL_HINT_RENDER_DRIVER can be set if you prefer "opengl", "metal", etc.
-    g_window = SDL_CreateWindow(
-        title ? title : "HexLib",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        width, height,
-        SDL_WINDOW_SHOWN
-    );
-    if (!g_window) {
-        SDL_Log("CreateWindow failed: %s", SDL_GetError());
-        SDL_Quit();
-        return 0;
-    }
 
-    // SDL_Renderer with geometry support (SDL 2.0.18+)
-    g_renderer = SDL_CreateRenderer(g_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!g_renderer) {
-        SDL_Log("CreateRenderer failed: %s", SDL_GetError());
-        SDL_DestroyWindow(g_window);
-        SDL_Quit();
-        return 0;
+static int SDLCALL pool_thread(void* arg) {
+    int thread = (int)(intptr_t)arg;
+    for (;;) {
+        SDL_SemWait(g_pool_start);
+        if (g_pool_quit) break;
+        pool_work(thread);
+        SDL_SemPost(g_pool_done);
     }
-    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+    return 0;
+}
 
-    int img_flags = IMG_INIT_PNG | IMG_INIT_JPG;
-    int img_init = IMG_Init(img_flags);
-    if ((img_init & img_flags) != img_flags) {
-        SDL_Log("IMG_Init warning: %s", IMG_GetError());
+static void pool_stop(void) {
+    if (g_pool_size > 1) {
+        g_pool_quit = 1;
+        for (int i = 1; i < g_pool_size; ++i) SDL_SemPost(g_pool_start);
+        for (int i = 1; i < g_pool_size; ++i) SDL_WaitThread(g_pool_threads[i], NULL);
     }
-    return 1;
+    if (g_pool_start) { SDL_DestroySemaphore(g_pool_start); g_pool_start = NULL; }
+    if (g_pool_done) { SDL_DestroySemaphore(g_pool_done); g_pool_done = NULL; }
+    g_pool_quit = 0;
+    g_pool_size = 0;
 }
 
-HEXLIB_API void hl_shutdown(void) {
-    hl_clear_tiles();
-    hl_clear_textures();
-    if (g_instances) { free(g_instances); g_instances = NULL; g_instance_count = 0; }
-    if (g_labels) { free(g_labels); g_labels = NULL; g_label_count = 0; }
-    if (g_renderer) { SDL_DestroyRenderer(g_renderer); g_renderer = NULL; }
-    if (g_window)   { SDL_DestroyWindow(g_window); g_window = NULL; }
-    IMG_Quit();
-    SDL_Quit();
+// Start the workers on first use. Returns the participant count; 1 means
+// jobs run inline on the calling thread.
+static int pool_start(void) {
+    if (g_pool_size) return g_pool_size;
+    int want = g_pool_wanted > 0 ? g_pool_wanted : SDL_GetCPUCount();
+    if (want > HL_MAX_THREADS) want = HL_MAX_THREADS;
+    g_pool_size = 1;
+    if (want <= 1) return 1;
+    g_pool_start = SDL_CreateSemaphore(0);
+    g_pool_done = SDL_CreateSemaphore(0);
+    if (!g_pool_start || !g_pool_done) {
+        SDL_Log("Worker pool semaphores failed: %s", SDL_GetError());
+        pool_stop();
+        g_pool_size = 1;
+        return 1;
+    }
+    for (int i = 1; i < want; ++i) {
+        g_pool_threads[i] = SDL_CreateThread(pool_thread, "hexlib-worker", (void*)(intptr_t)i);
+        if (!g_pool_threads[i]) {
+            SDL_Log("Worker thread %d failed: %s", i, SDL_GetError());
+            break;
+        }
+        g_pool_size++;
+    }
+    return g_pool_size;
 }
 
-HEXLIB_API void hl_set_grid(int rows, int cols, float hex_size, int flat_top) {
-    g_grid.rows = rows;
-    g_grid.cols = cols;
-    g_grid.size = hex_size;
-    g_grid.flat_top = flat_top ? 1 : 0;
-
-    // Center grid roughly in window
-    int w=0,h=0;
-    SDL_GetWindowSize(g_window, &w, &h);
-    float grid_w = (3.0f/2.0f * (cols-1) * hex_size) + 2.0f*hex_size;
-    float grid_h = (sqrtf(3.0f) * hex_size * (rows + 0.5f)) + hex_size;
-    float origin_x = (w - grid_w) * 0.5f + hex_size;
-    float origin_y = (h - grid_h) * 0.5f + hex_size;
-    if (grid_w > w) origin_x = w * 0.5f;
-    if (grid_h > h) origin_y = h * 0.5f;
-    g_grid.origin_x = origin_x;
-    g_grid.origin_y = origin_y;
+// Run fn(ctx, i, thread) for every i in [0, count) and wait for all of them
+static void pool_run(HL_PoolFn fn, void* ctx, int count) {
+    int size = pool_start();
+    if (size <= 1 || count <= HL_POOL_GRAIN) {
+        for (int i = 0; i < count; ++i) fn(ctx, i, 0);
+        return;
+    }
+    g_pool_fn = fn;
+    g_pool_ctx = ctx;
+    for (int k = 0; k < size; ++k) {
+        g_pool_shares[k].begin = (int)((long long)count * k / size);
+        g_pool_shares[k].end = (int)((long long)count * (k + 1) / size);
+    }
+    for (int k = 1; k < size; ++k) SDL_SemPost(g_pool_start);
+    pool_work(0);
+    for (int k = 1; k < size; ++k) SDL_SemWait(g_pool_done);
 }
 
-HEXLIB_API void hl_set_camera(float offset_x, float offset_y, float zoom) {
-    g_camera_offset_x = offset_x;
-    g_camera_offset_y = offset_y;
-    if (zoom < 0.05f) zoom = 0.05f;
-    g_camera_zoom = zoom;
+HEXLIB_API int hl_set_thread_count(int threads) {
+    if (threads < 0) threads = 0;
+    if (threads > HL_MAX_THREADS) threads = HL_MAX_THREADS;
+    if (threads != g_pool_wanted) {
+        pool_stop();
+        g_pool_wanted = threads;
+    }
+    return pool_start();
 }
 
-HEXLIB_API void hl_set_instances(const HL_HexInstance* instances, int count) {
-    if (g_tiles) { free(g_tiles); g_tiles = NULL; g_tile_count = 0; }
-    if (g_labels) { free(g_labels); g_labels = NULL; g_label_count = 0; }
-    if (g_instances) { free(g_instances); g_instances = NULL; g_instance_count = 0; }
-    if (count <= 0 || !instances) return;
-    g_instances = (HL_HexInstance*)malloc(sizeof(HL_HexInstance) * count);
-    if (!g_instances) return;
-    memcpy(g_instances, instances, sizeof(HL_HexInstance) * count);
-    g_instance_count = count;
-}
+// --- Texture loader ---
+// hl_load_texture_async hands the file to a loader thread, which decodes it
+// and converts it to RGBA32 (CPU work that needs no renderer). The render
+// thread installs finished surfaces at the start of hl_step within a time
+// budget. Each slot carries a generation so a result superseded by a later
+// load, unload or clear of the same slot is dropped instead of installed.
+#define HL_MAX_LOADERS 8
 
-static void destroy_texture_slot(int slot) {
-    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return;
-    if (g_textures[slot].texture) {
-        SDL_DestroyTexture(g_textures[slot].texture);
-        g_textures[slot].texture = NULL;
-    }
-    g_textures[slot].w = 0;
-    g_textures[slot].h = 0;
-}
+enum { HL_LOAD_IDLE, HL_LOAD_PENDING, HL_LOAD_FAILED };
 
-HEXLIB_API int hl_load_texture(int slot, const char* path) {
-    if (!g_renderer || !path) return 0;
-    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
+typedef struct HL_LoadJob {
+    struct HL_LoadJob* next;
+    int          slot;
+    uint32_t     generation;
+    SDL_Surface* surface;  // decoded RGBA32, NULL if decoding failed
+    char         path[];
+} HL_LoadJob;
 
-    destroy_texture_slot(slot);
+static SDL_Thread*  g_load_threads[HL_MAX_LOADERS];
+static int          g_load_thread_count = 0;  // 0 = not started
+static SDL_sem*     g_load_pending = NULL;    // one post per queued job, plus one per thread to quit
+static SDL_SpinLock g_load_lock = 0;          // guards both lists
+static HL_LoadJob*  g_load_queue = NULL;      // waiting for a loader, oldest first
+static HL_LoadJob*  g_load_queue_tail = NULL;
+static HL_LoadJob*  g_load_done = NULL;       // decoded, waiting for upload, oldest first
+static HL_LoadJob*  g_load_done_tail = NULL;
+static uint32_t     g_load_generation[HL_MAX_TEXTURE_SLOTS];
+static uint8_t      g_load_state[HL_MAX_TEXTURE_SLOTS];
+static float        g_upload_budget_ms = 2.0f;
 
+// Read an image file into an RGBA32 surface. Safe on any thread.
+static SDL_Surface* texture_decode(const char* path) {
     SDL_Surface* surf = IMG_Load(path);
     if (!surf) {
         SDL_Log("IMG_Load failed for '%s': %s", path, IMG_GetError());
         surf = SDL_LoadBMP(path);
         if (!surf) {
             SDL_Log("SDL_LoadBMP fallback failed for '%s': %s", path, SDL_GetError());
-            return 0;
+            return NULL;
         }
     }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surf);
+    if (!rgba) SDL_Log("SDL_ConvertSurfaceFormat failed for '%s': %s", path, SDL_GetError());
+    return rgba;
+}
 
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(g_renderer, surf);
-    if (!tex) {
-        SDL_Log("SDL_CreateTextureFromSurface failed for '%s': %s", path, SDL_GetError());
-        SDL_FreeSurface(surf);
-        return 0;
+static void load_job_free(HL_LoadJob* job) {
+    if (job->surface) SDL_FreeSurface(job->surface);
+    free(job);
+}
+
+static int SDLCALL loader_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        SDL_SemWait(g_load_pending);
+        SDL_AtomicLock(&g_load_lock);
+        HL_LoadJob* job = g_load_queue;
+        if (job) {
+            g_load_queue = job->next;
+            if (!g_load_queue) g_load_queue_tail = NULL;
+        }
+        SDL_AtomicUnlock(&g_load_lock);
+        if (!job) break;  // posted with an empty queue: quit
+
+        job->surface = texture_decode(job->path);
+        job->next = NULL;
+        SDL_AtomicLock(&g_load_lock);
+        if (g_load_done_tail) g_load_done_tail->next = job;
+        else g_load_done = job;
+        g_load_done_tail = job;
+        SDL_AtomicUnlock(&g_load_lock);
     }
+    return 0;
+}
 
-    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
-    g_textures[slot].texture = tex;
-    g_textures[slot].w = surf->w;
-    g_textures[slot].h = surf->h;
-    SDL_FreeSurface(surf);
-    return 1;
+// Drop queued and finished jobs and join the loader threads
+static void loader_stop(void) {
+    SDL_AtomicLock(&g_load_lock);
+    HL_LoadJob* queued = g_load_queue;
+    g_load_queue = g_load_queue_tail = NULL;
+    SDL_AtomicUnlock(&g_load_lock);
+    while (queued) {
+        HL_LoadJob* next = queued->next;
+        load_job_free(queued);
+        queued = next;
+    }
+    for (int i = 0; i < g_load_thread_count; ++i) SDL_SemPost(g_load_pending);
+    for (int i = 0; i < g_load_thread_count; ++i) SDL_WaitThread(g_load_threads[i], NULL);
+    g_load_thread_count = 0;
+    if (g_load_pending) { SDL_DestroySemaphore(g_load_pending); g_load_pending = NULL; }
+    while (g_load_done) {
+        HL_LoadJob* next = g_load_done->next;
+        load_job_free(g_load_done);
+        g_load_done = next;
+    }
+    g_load_done_tail = NULL;
+    memset(g_load_state, HL_LOAD_IDLE, sizeof(g_load_state));
 }
 
-HEXLIB_API void hl_unload_texture(int slot) {
-    destroy_texture_slot(slot);
+// Start the loaders on first use, sized like the worker pool. Returns 0 if
+// no thread could be started.
+static int loader_start(void) {
+    if (g_load_thread_count) return 1;
+    int want = g_pool_wanted > 0 ? g_pool_wanted : SDL_GetCPUCount();
+    if (want < 1) want = 1;
+    if (want > HL_MAX_LOADERS) want = HL_MAX_LOADERS;
+    if (!g_load_pending) g_load_pending = SDL_CreateSemaphore(0);
+    if (!g_load_pending) {
+        SDL_Log("Texture loader semaphore failed: %s", SDL_GetError());
+        return 0;
+    }
+    for (int i = 0; i < want; ++i) {
+        g_load_threads[i] = SDL_CreateThread(loader_thread, "hexlib-loader", NULL);
+        if (!g_load_threads[i]) {
+            SDL_Log("Texture loader thread %d failed: %s", i, SDL_GetError());
+            break;
+        }
+        g_load_thread_count++;
+    }
+    return g_load_thread_count > 0;
 }
 
-HEXLIB_API void hl_clear_textures(void) {
-    for (int i = 0; i < HL_MAX_TEXTURE_SLOTS; ++i) {
-        destroy_texture_slot(i);
+static void loader_submit(HL_LoadJob* job) {
+    job->next = NULL;
+    SDL_AtomicLock(&g_load_lock);
+    if (g_load_queue_tail) g_load_queue_tail->next = job;
+    else g_load_queue = job;
+    g_load_queue_tail = job;
+    SDL_AtomicUnlock(&g_load_lock);
+    SDL_SemPost(g_load_pending);
+}
+
+// Take the oldest finished job, or the one for `slot` if slot >= 0
+static HL_LoadJob* loader_take_done(int slot) {
+    SDL_AtomicLock(&g_load_lock);
+    HL_LoadJob* prev = NULL;
+    HL_LoadJob* job = g_load_done;
+    while (job && slot >= 0 && job->slot != slot) {
+        prev = job;
+        job = job->next;
     }
+    if (job) {
+        if (prev) prev->next = job->next;
+        else g_load_done = job->next;
+        if (g_load_done_tail == job) g_load_done_tail = prev;
+    }
+    SDL_AtomicUnlock(&g_load_lock);
+    return job;
 }
 
-HEXLIB_API void hl_set_tiles(const HL_TileInstance* tiles, int count) {
-    if (g_instances) { free(g_instances); g_instances = NULL; g_instance_count = 0; }
-    if (g_tiles) { free(g_tiles); g_tiles = NULL; g_tile_count = 0; }
-    if (count <= 0 || !tiles) return;
-    g_tiles = (HL_TileInstance*)malloc(sizeof(HL_TileInstance) * count);
-    if (!g_tiles) return;
-    memcpy(g_tiles, tiles, sizeof(HL_TileInstance) * count);
-    g_tile_count = count;
+// Forget any async load in flight for `slot`
+static void loader_cancel(int slot) {
+    g_load_generation[slot]++;
+    g_load_state[slot] = HL_LOAD_IDLE;
 }
 
-HEXLIB_API void hl_clear_tiles(void) {
-    if (g_tiles) { free(g_tiles); g_tiles = NULL; }
-    g_tile_count = 0;
-    if (g_labels) { free(g_labels); g_labels = NULL; g_label_count = 0; }
+// --- Pathfinding ---
+// Movement costs live in a dense byte grid over an axial rectangle, padded by
+// a ring of blocked cells so neighbour lookups never bounds-check. The grid
+// is shared read-only by every query; the search state lives in one scratch
+// per pool thread, sized with the grid. A generation stamp tells which
+// entries the current query wrote, so nothing is cleared between queries and
+// nothing is allocated once a scratch heap has grown to the map.
+#define HL_PATH_ORIGIN 6   // g_path_scratch.from value of the search origin
+
+typedef struct {
+    uint32_t f;      // priority: cost so far plus heuristic (Dijkstra: no heuristic)
+    uint32_t g;      // cost so far when pushed; stale once the cell's dist moves below it
+    int      cell;
+} HL_PathNode;
+
+typedef struct {
+    uint32_t*    dist;         // best known cost from the origin
+    uint32_t*    stamp;        // gen when dist/from were last written
+    uint8_t*     from;         // direction index that reached the cell (HL_PATH_ORIGIN at the origin)
+    uint32_t     gen;
+    int          cells;        // capacity of the per-cell arrays
+    HL_PathNode* heap;
+    int          heap_count;
+    int          heap_cap;
+    int          allocations;  // heap growth on a worker, folded into the stats by the caller
+} HL_PathScratch;
+
+static uint8_t*       g_path_cost = NULL;  // per padded cell, cost of entering it; 0 = blocked
+static int            g_path_cells = 0;    // padded cell count
+static int            g_path_cost_cap = 0;
+static int32_t        g_path_q0 = 0, g_path_r0 = 0;  // axial coordinate of the first unpadded cell
+static int            g_path_w = 0, g_path_h = 0;    // unpadded size
+static uint32_t       g_path_min_cost = 1;           // cheapest step, scales the A* heuristic
+static int            g_path_step[6];                // neighbour offsets in padded cells
+static HL_PathScratch g_path_scratch[HL_MAX_THREADS];
+
+static int hex_distance(int32_t q0, int32_t r0, int32_t q1, int32_t r1) {
+    int32_t dq = q0 - q1, dr = r0 - r1;
+    return (abs(dq) + abs(dr) + abs(dq + dr)) / 2;
 }
 
-HEXLIB_API void hl_set_debug_labels(const HL_DebugLabel* labels, int count) {
-    if (g_labels) { free(g_labels); g_labels = NULL; g_label_count = 0; }
-    if (!labels || count <= 0) return;
-    g_labels = (HL_DebugLabel*)malloc(sizeof(HL_DebugLabel) * count);
-    if (!g_labels) return;
-    memcpy(g_labels, labels, sizeof(HL_DebugLabel) * count);
-    g_label_count = count;
+static int path_cell(int32_t q, int32_t r) {
+    int32_t x = q - g_path_q0, y = r - g_path_r0;
+    if (!g_path_cost || x < 0 || y < 0 || x >= g_path_w || y >= g_path_h) return -1;
+    return (y + 1) * (g_path_w + 2) + x + 1;
 }
 
-HEXLIB_API int hl_query_texture(int slot, int* out_w, int* out_h) {
-    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
-    if (!g_textures[slot].texture) return 0;
-    if (out_w) *out_w = g_textures[slot].w;
-    if (out_h) *out_h = g_textures[slot].h;
+static int32_t path_cell_q(int cell) { return cell % (g_path_w + 2) - 1 + g_path_q0; }
+static int32_t path_cell_r(int cell) { return cell / (g_path_w + 2) - 1 + g_path_r0; }
+
+static void path_scratch_free(HL_PathScratch* s) {
+    free(s->dist);
+    free(s->stamp);
+    free(s->from);
+    free(s->heap);
+    memset(s, 0, sizeof(*s));
+}
+
+// Size a scratch for the current grid. Runs on the calling thread only.
+static int path_scratch_reserve(HL_PathScratch* s) {
+    if (s->cells >= g_path_cells) return 1;
+    free(s->dist);
+    free(s->stamp);
+    free(s->from);
+    s->dist = (uint32_t*)heap_malloc(sizeof(uint32_t) * g_path_cells);
+    s->stamp = (uint32_t*)heap_calloc((size_t)g_path_cells, sizeof(uint32_t));
+    s->from = (uint8_t*)heap_malloc((size_t)g_path_cells);
+    s->gen = 0;
+    s->cells = 0;
+    if (!s->dist || !s->stamp || !s->from) {
+        SDL_Log("Path scratch for %d cells: out of memory", g_path_cells);
+        path_scratch_free(s);
+        return 0;
+    }
+    s->cells = g_path_cells;
     return 1;
 }
 
-HEXLIB_API void hl_set_clear_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-    g_clear.r = r; g_clear.g = g; g_clear.b = b; g_clear.a = a;
+static void path_begin(HL_PathScratch* s) {
+    s->heap_count = 0;
+    if (++s->gen == 0) {
+        memset(s->stamp, 0, sizeof(uint32_t) * s->cells);
+        s->gen = 1;
+    }
 }
 
-static void draw_hex_filled(float cx, float cy, float size, SDL_Color c) {
-#if SDL_VERSION_ATLEAST(2,0,18)
-    SDL_FPoint p[6];
-    hex_corners_flat(cx, cy, size, p);
+static uint32_t path_dist(const HL_PathScratch* s, int cell) {
+    return s->stamp[cell] == s->gen ? s->dist[cell] : UINT32_MAX;
+}
+
+static void path_set(HL_PathScratch* s, int cell, uint32_t dist, uint8_t from) {
+    s->stamp[cell] = s->gen;
+    s->dist[cell] = dist;
+    s->from[cell] = from;
+}
 
-    // Tri fan: (p0, p1, p2), (p0, p2, p3), ... (p0, p5, p0) (implicitly)
-    const int tri_count = 4; // Actually 4? For hex it should be 4? It's 4 for quad—correct it:
-    // For hex: triangles = 4? No, it's (n - 2) = 4. Yes, 6 corners => 4 triangles using fan.
-    SDL_Vertex verts[12]; // 4 tris * 3 verts
+// Min-heap on f; among equal f the deeper node (larger g) wins, which keeps
+// A* on the straight line instead of widening across equal-cost ties.
+static int path_node_before(const HL_PathNode* a, const HL_PathNode* b) {
+    return a->f < b->f || (a->f == b->f && a->g > b->g);
+}
 
-    int vi = 0;
-    for (int t = 0; t < 4; ++t) {
-        SDL_FPoint a = p[0];
-        SDL_FPoint b = p[t+1];
-        SDL_FPoint d = p[t+2];
-        SDL_Vertex v0 = { {a.x, a.y}, { c.r/255.0f, c.g/255.0f, c.b/255.0f, c.a/255.0f }, {0,0} };
-        SDL_Vertex v1 = { {b.x, b.y}, { c.r/255.0f, c.g/255.0f, c.b/255.0f, c.a/255.0f }, {0,0} };
-        SDL_Vertex v2 = { {d.x, d.y}, { c.r/255.0f, c.g/255.0f, c.b/255.0f, c.a/255.0f }, {0,0} };
-        verts[vi++] = v0; verts[vi++] = v1; verts[vi++] = v2;
-    }
-    SDL_RenderGeometry(g_renderer, NULL, verts, vi, NULL, 0);
-
-    // Outline
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 200);
-    for (int i = 0; i < 6; ++i) {
-        SDL_RenderDrawLineF(g_renderer, p[i].x, p[i].y, p[(i+1)%6].x, p[(i+1)%6].y);
+static int path_heap_push(HL_PathScratch* s, uint32_t f, uint32_t g, int cell) {
+    if (s->heap_count == s->heap_cap) {
+        // May run on a worker thread: plain realloc, counted by the caller
+        int cap = s->heap_cap ? s->heap_cap * 2 : 256;
+        HL_PathNode* heap = (HL_PathNode*)realloc(s->heap, sizeof(HL_PathNode) * cap);
+        if (!heap) return 0;
+        s->heap = heap;
+        s->heap_cap = cap;
+        s->allocations++;
     }
-#else
-    // Fallback: just outline (older SDL2)
-    SDL_FPoint p[6];
-    hex_corners_flat(cx, cy, size, p);
-    SDL_SetRenderDrawColor(g_renderer, c.r, c.g, c.b, c.a);
-    for (int i = 0; i < 6; ++i) {
-        SDL_RenderDrawLineF(g_renderer, p[i].x, p[i].y, p[(i+1)%6].x, p[(i+1)%6].y);
+    HL_PathNode node = { f, g, cell };
+    int i = s->heap_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!path_node_before(&node, &s->heap[parent])) break;
+        s->heap[i] = s->heap[parent];
+        i = parent;
     }
-#endif
+    s->heap[i] = node;
+    return 1;
 }
 
-static void texture_dest_rect(const HL_TextureSlot* slot, float target_w, float target_h, float cx, float cy, float scale_mul, SDL_FRect* out_rect) {
-    float w = target_w;
-    float h = target_h;
-    if (scale_mul <= 0.01f) scale_mul = 0.01f;
-    if (slot && slot->texture && slot->w > 0 && slot->h > 0) {
-        float scale = (target_w / (float)slot->w);
-        w = target_w * scale_mul;
-        h = (float)slot->h * scale * scale_mul;
+static HL_PathNode path_heap_pop(HL_PathScratch* s) {
+    HL_PathNode top = s->heap[0];
+    HL_PathNode last = s->heap[--s->heap_count];
+    int n = s->heap_count, i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && path_node_before(&s->heap[child + 1], &s->heap[child])) child++;
+        if (!path_node_before(&s->heap[child], &last)) break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    s->heap[i] = last;
+    return top;
+}
+
+static void path_fold_allocations(void) {
+    for (int t = 0; t < HL_MAX_THREADS; ++t) {
+        HL_STAT_ADD(allocations, (uint32_t)g_path_scratch[t].allocations);
+        HL_STAT_ADD(total_allocations, (uint64_t)g_path_scratch[t].allocations);
+        g_path_scratch[t].allocations = 0;
+    }
+}
+
+static void path_free(void) {
+    free(g_path_cost);
+    g_path_cost = NULL;
+    g_path_cells = g_path_cost_cap = 0;
+    g_path_w = g_path_h = 0;
+    for (int t = 0; t < HL_MAX_THREADS; ++t) path_scratch_free(&g_path_scratch[t]);
+}
+
+// A* from `start` to `goal` (padded cells). Writes up to max_out (q, r)
+// pairs and returns the path length in hexes, or 0 if there is none or the
+// heap could not grow.
+static int path_search(HL_PathScratch* s, int start, int goal, int32_t* out, int max_out) {
+    if (start != goal && g_path_cost[goal] == 0) return 0;
+    int32_t gq = path_cell_q(goal), gr = path_cell_r(goal);
+    path_begin(s);
+    path_set(s, start, 0, HL_PATH_ORIGIN);
+    uint32_t h0 = (uint32_t)hex_distance(path_cell_q(start), path_cell_r(start), gq, gr) * g_path_min_cost;
+    int reached = 0, failed = !path_heap_push(s, h0, 0, start);
+    while (!failed && s->heap_count > 0) {
+        HL_PathNode node = path_heap_pop(s);
+        if (node.g != s->dist[node.cell]) continue;  // superseded by a cheaper push
+        if (node.cell == goal) {
+            reached = 1;
+            break;
+        }
+        for (int d = 0; d < 6; ++d) {
+            int next = node.cell + g_path_step[d];
+            uint32_t step = g_path_cost[next];
+            if (step == 0) continue;
+            uint32_t dist = node.g + step;
+            if (dist >= path_dist(s, next)) continue;
+            path_set(s, next, dist, (uint8_t)d);
+            uint32_t h = (uint32_t)hex_distance(path_cell_q(next), path_cell_r(next), gq, gr) * g_path_min_cost;
+            if (!path_heap_push(s, dist + h, dist, next)) {
+                failed = 1;
+                break;
+            }
+        }
+    }
+    if (failed) SDL_Log("Path search: out of memory");
+    if (!reached) return 0;
+
+    // Walk the directions back from the goal, filling `out` from its end
+    int len = 1;
+    for (int c = goal; s->from[c] != HL_PATH_ORIGIN; c -= g_path_step[s->from[c]]) len++;
+    int k = len;
+    for (int c = goal;; c -= g_path_step[s->from[c]]) {
+        --k;
+        if (out && k < max_out) {
+            out[k * 2] = path_cell_q(c);
+            out[k * 2 + 1] = path_cell_r(c);
+        }
+        if (s->from[c] == HL_PATH_ORIGIN) break;
+    }
+    return len;
+}
+
+HEXLIB_API int hl_set_path_grid(int32_t q0, int32_t r0, int width, int height, const uint8_t* costs) {
+    if (!costs || width <= 0 || height <= 0) {
+        path_free();
+        return 1;
+    }
+    int cells = (width + 2) * (height + 2);
+    if (cells > g_path_cost_cap) {
+        free(g_path_cost);
+        g_path_cost = (uint8_t*)heap_malloc((size_t)cells);
+        if (!g_path_cost) {
+            SDL_Log("Path grid %dx%d: out of memory", width, height);
+            path_free();
+            return 0;
+        }
+        g_path_cost_cap = cells;
+    }
+    HL_STAT_ADD(total_bytes_uploaded, (uint64_t)width * height);
+    g_path_cells = cells;
+    g_path_q0 = q0;
+    g_path_r0 = r0;
+    g_path_w = width;
+    g_path_h = height;
+    int stride = width + 2;
+    // Axial neighbour directions: (+1,0) (+1,-1) (0,-1) (-1,0) (-1,+1) (0,+1)
+    g_path_step[0] = 1;
+    g_path_step[1] = 1 - stride;
+    g_path_step[2] = -stride;
+    g_path_step[3] = -1;
+    g_path_step[4] = stride - 1;
+    g_path_step[5] = stride;
+
+    memset(g_path_cost, 0, (size_t)cells);
+    uint8_t min_cost = 255;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = costs + (size_t)y * width;
+        memcpy(g_path_cost + (y + 1) * stride + 1, row, (size_t)width);
+        for (int x = 0; x < width; ++x) {
+            if (row[x] && row[x] < min_cost) min_cost = row[x];
+        }
+    }
+    g_path_min_cost = min_cost;
+    return 1;
+}
+
+HEXLIB_API int hl_set_path_cost(int32_t q, int32_t r, uint8_t cost) {
+    int cell = path_cell(q, r);
+    if (cell < 0) return 0;
+    g_path_cost[cell] = cost;
+    // Raising the cheapest cell leaves the heuristic low: still admissible
+    if (cost && cost < g_path_min_cost) g_path_min_cost = cost;
+    return 1;
+}
+
+HEXLIB_API int hl_reachable(int32_t q, int32_t r, int budget, int32_t* out, int max_out) {
+    HL_PathScratch* s = &g_path_scratch[0];
+    int origin = path_cell(q, r);
+    if (origin < 0 || budget < 0 || !path_scratch_reserve(s)) return 0;
+    path_begin(s);
+    path_set(s, origin, 0, HL_PATH_ORIGIN);
+    int found = 0, failed = !path_heap_push(s, 0, 0, origin);
+    while (!failed && s->heap_count > 0) {
+        HL_PathNode node = path_heap_pop(s);
+        if (node.g != s->dist[node.cell]) continue;
+        if (node.cell != origin) {
+            if (out && found < max_out) {
+                out[found * 2] = path_cell_q(node.cell);
+                out[found * 2 + 1] = path_cell_r(node.cell);
+            }
+            found++;
+        }
+        for (int d = 0; d < 6; ++d) {
+            int next = node.cell + g_path_step[d];
+            uint32_t step = g_path_cost[next];
+            if (step == 0) continue;
+            uint32_t dist = node.g + step;
+            if (dist > (uint32_t)budget || dist >= path_dist(s, next)) continue;
+            path_set(s, next, dist, (uint8_t)d);
+            // A cell whose push failed would never be expanded: stop rather
+            // than return a truncated set
+            if (!path_heap_push(s, dist, dist, next)) {
+                failed = 1;
+                break;
+            }
+        }
+    }
+    path_fold_allocations();
+    if (failed) {
+        SDL_Log("Reachable set from (%d, %d): out of memory", q, r);
+        return 0;
+    }
+    return found;
+}
+
+HEXLIB_API int hl_find_path(int32_t q0, int32_t r0, int32_t q1, int32_t r1, int32_t* out, int max_out) {
+    int start = path_cell(q0, r0);
+    int goal = path_cell(q1, r1);
+    if (start < 0 || goal < 0 || !path_scratch_reserve(&g_path_scratch[0])) return 0;
+    int len = path_search(&g_path_scratch[0], start, goal, out, max_out);
+    path_fold_allocations();
+    return len;
+}
+
+typedef struct {
+    const HL_PathQuery* queries;
+    int32_t* lengths;
+    int32_t* coords;
+    int      max_path;
+} HL_PathBatch;
+
+static void path_batch_job(void* ctx, int index, int thread) {
+    const HL_PathBatch* batch = (const HL_PathBatch*)ctx;
+    const HL_PathQuery* query = &batch->queries[index];
+    int start = path_cell(query->q0, query->r0);
+    int goal = path_cell(query->q1, query->r1);
+    int32_t* out = batch->coords ? batch->coords + (size_t)index * batch->max_path * 2 : NULL;
+    int len = 0;
+    if (start >= 0 && goal >= 0) len = path_search(&g_path_scratch[thread], start, goal, out, batch->max_path);
+    batch->lengths[index] = len;
+}
+
+HEXLIB_API int hl_find_paths_batch(const HL_PathQuery* queries, int count, int32_t* lengths, int32_t* coords, int max_path) {
+    if (!queries || !lengths || count <= 0) return 0;
+    if (max_path < 0) max_path = 0;
+    if (!g_path_cost) {
+        memset(lengths, 0, sizeof(int32_t) * count);
+        return 0;
+    }
+    int threads = pool_start();
+    for (int t = 0; t < threads; ++t) {
+        if (!path_scratch_reserve(&g_path_scratch[t])) {
+            memset(lengths, 0, sizeof(int32_t) * count);
+            return 0;
+        }
+    }
+    HL_PathBatch batch = { queries, lengths, coords, max_path };
+    pool_run(path_batch_job, &batch, count);
+    path_fold_allocations();
+    int found = 0;
+    for (int i = 0; i < count; ++i) found += lengths[i] > 0;
+    return found;
+}
+
+// --- Visibility ---
+// Opacity lives in a byte grid over an axial rectangle like the path grid;
+// hexes outside it block sight. Field of view is ring-by-ring shadowcasting:
+// hex i of ring k spans (i -/+ 1/2) / 6k of a full turn, and every ring
+// starts in the same direction, so spans line up from ring to ring. A lit
+// opaque hex adds its span to a sorted list of shadows. Floor hexes are lit
+// while their center is outside every shadow, walls while any part of their
+// span is. Each faction keeps one bit per grid hex for what its viewers see
+// now and one for what it has ever seen. hl_update_fog scans the viewers on
+// the worker pool into per-thread bitsets and merges them with word-wide ORs.
+
+typedef struct {
+    float lo, hi;  // fraction of a full turn, within [0, 1]
+} HL_Shadow;
+
+typedef struct {
+    uint64_t*  bits;         // FOV of the viewers this thread scanned
+    HL_Shadow* shadows;
+    int        shadow_cap;
+} HL_VisScratch;
+
+typedef struct {
+    uint64_t* visible;       // NULL until the faction's first update
+    uint64_t* explored;
+} HL_Fog;
+
+static uint8_t*      g_vis_opaque = NULL;   // per grid hex, nonzero blocks sight
+static int32_t       g_vis_q0 = 0, g_vis_r0 = 0;
+static int           g_vis_w = 0, g_vis_h = 0;
+static int           g_vis_cap = 0;         // g_vis_opaque capacity in hexes
+static int           g_vis_words = 0;       // uint64_t words per bitset
+static HL_Fog        g_fog[HL_MAX_FACTIONS];
+static HL_VisScratch g_vis_scratch[HL_MAX_THREADS];
+static int           g_fog_view = -1;       // faction whose fog hl_step draws
+static SDL_Color     g_fog_explored = { 0, 0, 0, 140 };
+static SDL_Color     g_fog_hidden = { 0, 0, 0, 255 };
+static uint32_t      g_fog_version = 0;     // bumped when the drawn fog changes
+
+static int vis_cell(int32_t q, int32_t r) {
+    int32_t x = q - g_vis_q0, y = r - g_vis_r0;
+    if (!g_vis_opaque || x < 0 || y < 0 || x >= g_vis_w || y >= g_vis_h) return -1;
+    return y * g_vis_w + x;
+}
+
+static void vis_scratch_free(HL_VisScratch* s) {
+    free(s->bits);
+    free(s->shadows);
+    memset(s, 0, sizeof(*s));
+}
+
+static void fog_free(HL_Fog* f) {
+    free(f->visible);
+    free(f->explored);
+    f->visible = f->explored = NULL;
+}
+
+// Fog and per-thread bitsets are sized to the grid; drop them when it changes
+static void vis_bits_free(void) {
+    for (int f = 0; f < HL_MAX_FACTIONS; ++f) fog_free(&g_fog[f]);
+    for (int t = 0; t < HL_MAX_THREADS; ++t) vis_scratch_free(&g_vis_scratch[t]);
+    g_fog_version++;
+}
+
+static void vis_free(void) {
+    vis_bits_free();
+    free(g_vis_opaque);
+    g_vis_opaque = NULL;
+    g_vis_w = g_vis_h = g_vis_cap = g_vis_words = 0;
+}
+
+// Size a scratch for the current grid and viewers up to `radius`. Runs on
+// the calling thread only.
+static int vis_scratch_reserve(HL_VisScratch* s, int radius) {
+    // Shadows are disjoint and at least one ring-`radius` span wide, plus the
+    // two slivers a span wrapping past 0 splits into
+    int shadows = 6 * radius + 2;
+    if (shadows > s->shadow_cap) {
+        HL_Shadow* grown = (HL_Shadow*)heap_realloc(s->shadows, sizeof(HL_Shadow) * shadows);
+        if (!grown) return 0;
+        s->shadows = grown;
+        s->shadow_cap = shadows;
+    }
+    if (!s->bits) s->bits = (uint64_t*)heap_malloc(sizeof(uint64_t) * (size_t)g_vis_words);
+    return s->bits != NULL;
+}
+
+static int fog_reserve(HL_Fog* f) {
+    if (f->visible) return 1;
+    f->visible = (uint64_t*)heap_calloc((size_t)g_vis_words, sizeof(uint64_t));
+    f->explored = (uint64_t*)heap_calloc((size_t)g_vis_words, sizeof(uint64_t));
+    if (!f->visible || !f->explored) {
+        SDL_Log("Fog for %d hexes: out of memory", g_vis_w * g_vis_h);
+        fog_free(f);
+        return 0;
+    }
+    return 1;
+}
+
+// Is [lo, hi] inside a single shadow? Shadows touching end to end are merged
+// on insert, so one is enough.
+static int shadow_covers(const HL_Shadow* sh, int n, float lo, float hi) {
+    for (int k = 0; k < n && sh[k].lo <= lo; ++k) {
+        if (sh[k].hi >= hi) return 1;
+    }
+    return 0;
+}
+
+// Insert [lo, hi] keeping the list sorted, merging what it overlaps or touches
+static int shadow_add(HL_Shadow* sh, int n, float lo, float hi) {
+    int k = 0;
+    while (k < n && sh[k].hi < lo) ++k;
+    int end = k;
+    while (end < n && sh[end].lo <= hi) {
+        lo = fminf(lo, sh[end].lo);
+        hi = fmaxf(hi, sh[end].hi);
+        ++end;
+    }
+    memmove(&sh[k + 1], &sh[end], sizeof(HL_Shadow) * (size_t)(n - end));
+    sh[k].lo = lo;
+    sh[k].hi = hi;
+    return n - (end - k) + 1;
+}
+
+// Shadowcast from (q, r). Sets the bit of every visible grid hex in `bits`
+// and, if `out` is given, writes up to max_out (q, r) pairs nearest first.
+// Returns the number of visible hexes.
+static int fov_scan(HL_VisScratch* s, int32_t q, int32_t r, int radius, uint64_t* bits, int32_t* out, int max_out) {
+    // Ring k starts k steps along (-1,+1) and walks k steps in each direction
+    static const int32_t dirs[6][2] = { { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, 0 }, { -1, 1 }, { 0, 1 } };
+    int cell = vis_cell(q, r);
+    if (cell < 0) return 0;
+    bits[cell >> 6] |= 1ull << (cell & 63);
+    if (out && max_out > 0) {
+        out[0] = q;
+        out[1] = r;
+    }
+    HL_Shadow* sh = s->shadows;
+    int found = 1, n = 0;
+    for (int k = 1; k <= radius; ++k) {
+        if (n == 1 && sh[0].lo <= 0.0f && sh[0].hi >= 1.0f) break;
+        float span = 1.0f / (6.0f * (float)k);
+        int32_t hq = q - k, hr = r + k;
+        for (int i = 0; i < 6 * k; ++i) {
+            float center = (float)i * span;
+            float lo = center - 0.5f * span, hi = center + 0.5f * span;
+            int hcell = vis_cell(hq, hr);
+            int opaque = hcell < 0 || g_vis_opaque[hcell];
+            int lit;
+            if (!opaque) lit = !shadow_covers(sh, n, center, center);
+            else if (lo < 0.0f) lit = !shadow_covers(sh, n, lo + 1.0f, 1.0f) || !shadow_covers(sh, n, 0.0f, hi);
+            else lit = !shadow_covers(sh, n, lo, hi);
+            if (lit && hcell >= 0) {
+                bits[hcell >> 6] |= 1ull << (hcell & 63);
+                if (out && found < max_out) {
+                    out[2 * found] = hq;
+                    out[2 * found + 1] = hr;
+                }
+                found++;
+            }
+            // A span only touches its ring neighbours' at the ends, so
+            // shadows added mid-ring never darken the rest of the ring
+            if (opaque && lit) {
+                if (lo < 0.0f) {
+                    n = shadow_add(sh, n, lo + 1.0f, 1.0f);
+                    lo = 0.0f;
+                }
+                n = shadow_add(sh, n, lo, hi);
+            }
+            hq += dirs[i / k][0];
+            hr += dirs[i / k][1];
+        }
+    }
+    return found;
+}
+
+// One viewer of hl_update_fog, scanned into the running thread's bitset
+static void fog_batch_job(void* ctx, int index, int thread) {
+    const HL_Viewer* v = &((const HL_Viewer*)ctx)[index];
+    if (v->radius < 0) return;
+    HL_VisScratch* s = &g_vis_scratch[thread];
+    fov_scan(s, v->q, v->r, v->radius, s->bits, NULL, 0);
+}
+
+static int popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static int fog_state(int faction, int32_t q, int32_t r) {
+    if (faction < 0 || faction >= HL_MAX_FACTIONS || !g_fog[faction].visible) return HL_FOG_HIDDEN;
+    int cell = vis_cell(q, r);
+    if (cell < 0) return HL_FOG_HIDDEN;
+    uint64_t bit = 1ull << (cell & 63);
+    if (g_fog[faction].visible[cell >> 6] & bit) return HL_FOG_VISIBLE;
+    return (g_fog[faction].explored[cell >> 6] & bit) ? HL_FOG_EXPLORED : HL_FOG_HIDDEN;
+}
+
+HEXLIB_API int hl_set_vision_grid(int32_t q0, int32_t r0, int width, int height, const uint8_t* opaque) {
+    if (!opaque || width <= 0 || height <= 0) {
+        vis_free();
+        return 1;
+    }
+    int cells = width * height;
+    // Fog survives re-uploading the same rectangle (say, after terrain edits)
+    if (q0 != g_vis_q0 || r0 != g_vis_r0 || width != g_vis_w || height != g_vis_h) vis_bits_free();
+    if (cells > g_vis_cap) {
+        free(g_vis_opaque);
+        g_vis_opaque = (uint8_t*)heap_malloc((size_t)cells);
+        if (!g_vis_opaque) {
+            SDL_Log("Vision grid %dx%d: out of memory", width, height);
+            vis_free();
+            return 0;
+        }
+        g_vis_cap = cells;
+    }
+    HL_STAT_ADD(total_bytes_uploaded, (uint64_t)cells);
+    memcpy(g_vis_opaque, opaque, (size_t)cells);
+    g_vis_q0 = q0;
+    g_vis_r0 = r0;
+    g_vis_w = width;
+    g_vis_h = height;
+    g_vis_words = (cells + 63) / 64;
+    return 1;
+}
+
+HEXLIB_API int hl_set_opaque(int32_t q, int32_t r, uint8_t opaque) {
+    int cell = vis_cell(q, r);
+    if (cell < 0) return 0;
+    g_vis_opaque[cell] = opaque;
+    return 1;
+}
+
+HEXLIB_API int hl_line_of_sight(int32_t q0, int32_t r0, int32_t q1, int32_t r1) {
+    if (vis_cell(q0, r0) < 0 || vis_cell(q1, r1) < 0) return 0;
+    int steps = hex_distance(q0, r0, q1, r1);
+    for (int i = 1; i < steps; ++i) {
+        int q, r;
+        hex_line_at(q0, r0, q1, r1, i, steps, &q, &r);
+        int cell = vis_cell(q, r);
+        if (cell < 0 || g_vis_opaque[cell]) return 0;
+    }
+    return 1;
+}
+
+HEXLIB_API int hl_fov(int32_t q, int32_t r, int radius, int32_t* out, int max_out) {
+    HL_VisScratch* s = &g_vis_scratch[0];
+    if (!out) max_out = 0;
+    if (radius < 0 || vis_cell(q, r) < 0 || !vis_scratch_reserve(s, radius)) return 0;
+    return fov_scan(s, q, r, radius, s->bits, out, max_out);
+}
+
+HEXLIB_API int hl_update_fog(int faction, const HL_Viewer* viewers, int count) {
+    if (faction < 0 || faction >= HL_MAX_FACTIONS || !g_vis_opaque) return 0;
+    HL_Fog* fog = &g_fog[faction];
+    if (!fog_reserve(fog)) return 0;
+    if (!viewers || count < 0) count = 0;
+    int radius = 0;
+    for (int i = 0; i < count; ++i) {
+        if (viewers[i].radius > radius) radius = viewers[i].radius;
+    }
+    int threads = pool_start();
+    for (int t = 0; t < threads; ++t) {
+        if (!vis_scratch_reserve(&g_vis_scratch[t], radius)) {
+            SDL_Log("Fog scratch: out of memory");
+            return 0;
+        }
+        memset(g_vis_scratch[t].bits, 0, sizeof(uint64_t) * (size_t)g_vis_words);
+    }
+    pool_run(fog_batch_job, (void*)viewers, count);
+
+    // A batch small enough to run inline leaves the other threads' bits clear
+    uint64_t* visible = fog->visible;
+    uint64_t* explored = fog->explored;
+    memcpy(visible, g_vis_scratch[0].bits, sizeof(uint64_t) * (size_t)g_vis_words);
+    for (int t = 1; t < threads; ++t) {
+        const uint64_t* bits = g_vis_scratch[t].bits;
+        for (int w = 0; w < g_vis_words; ++w) visible[w] |= bits[w];
+    }
+    int seen = 0;
+    for (int w = 0; w < g_vis_words; ++w) {
+        explored[w] |= visible[w];
+        seen += popcount64(visible[w]);
+    }
+    if (faction == g_fog_view) g_fog_version++;
+    return seen;
+}
+
+HEXLIB_API void hl_reset_fog(int faction) {
+    if (faction < 0 || faction >= HL_MAX_FACTIONS || !g_fog[faction].visible) return;
+    memset(g_fog[faction].visible, 0, sizeof(uint64_t) * (size_t)g_vis_words);
+    memset(g_fog[faction].explored, 0, sizeof(uint64_t) * (size_t)g_vis_words);
+    if (faction == g_fog_view) g_fog_version++;
+}
+
+HEXLIB_API int hl_fog_state(int faction, int32_t q, int32_t r) {
+    return fog_state(faction, q, r);
+}
+
+HEXLIB_API void hl_set_fog_view(int faction, HL_Color explored, HL_Color hidden) {
+    g_fog_view = faction >= 0 && faction < HL_MAX_FACTIONS ? faction : -1;
+    g_fog_explored = (SDL_Color){ explored.r, explored.g, explored.b, explored.a };
+    g_fog_hidden = (SDL_Color){ hidden.r, hidden.g, hidden.b, hidden.a };
+    g_fog_version++;
+}
+
+// Tint for a hex under the drawn fog; alpha 0 when it is in plain sight
+static SDL_Color fog_tint(int32_t q, int32_t r) {
+    static const SDL_Color clear = { 0, 0, 0, 0 };
+    if (g_fog_view < 0) return clear;
+    int state = fog_state(g_fog_view, q, r);
+    return state == HL_FOG_VISIBLE ? clear : state == HL_FOG_EXPLORED ? g_fog_explored : g_fog_hidden;
+}
+
+// Corner offsets relative to a hex center, shared by every hex drawn at the
+// current zoom. Rebuilt only when the on-screen hex size changes.
+static float      g_corner_size = -1.0f;
+static int        g_corner_flat = -1;  // orientation the corners were built for
+static SDL_FPoint g_corner_fill[6];   // polygon corners
+static SDL_FPoint g_corner_outer[6];  // outline ring, outer edge
+static SDL_FPoint g_corner_inner[6];  // outline ring, inner edge
+
+// Unit hex corners, step 60°: pointy-top [0] starts at 30°, flat-top [1] at 0°
+static const SDL_FPoint g_unit_corners[2][6] = {
+    {
+        {  HL_SQRT3 * 0.5f,  0.5f }, { 0.0f,  1.0f }, { -HL_SQRT3 * 0.5f,  0.5f },
+        { -HL_SQRT3 * 0.5f, -0.5f }, { 0.0f, -1.0f }, {  HL_SQRT3 * 0.5f, -0.5f },
+    },
+    {
+        {  1.0f, 0.0f }, {  0.5f,  HL_SQRT3 * 0.5f }, { -0.5f,  HL_SQRT3 * 0.5f },
+        { -1.0f, 0.0f }, { -0.5f, -HL_SQRT3 * 0.5f }, {  0.5f, -HL_SQRT3 * 0.5f },
+    },
+};
+
+static void update_corner_offsets(float size) {
+    if (size == g_corner_size && g_grid.flat_top == g_corner_flat) return;
+    g_corner_size = size;
+    g_corner_flat = g_grid.flat_top;
+    const SDL_FPoint* unit = g_unit_corners[g_grid.flat_top];
+    // Push the ring edges half a pixel either side of the hex edge (measured
+    // perpendicular to the edge, hence the 1/cos(30°) factor on the corners).
+    float half_line = 0.5f * (2.0f / HL_SQRT3);
+    float inner = size - half_line;
+    if (inner < 0.0f) inner = 0.0f;
+    for (int i = 0; i < 6; ++i) {
+        float cs = unit[i].x;
+        float sn = unit[i].y;
+        g_corner_fill[i].x = size * cs;
+        g_corner_fill[i].y = size * sn;
+        g_corner_outer[i].x = (size + half_line) * cs;
+        g_corner_outer[i].y = (size + half_line) * sn;
+        g_corner_inner[i].x = inner * cs;
+        g_corner_inner[i].y = inner * sn;
+    }
+}
+
+// --- Batched geometry ---
+// Every hex fill and outline of a frame is appended to one growable
+// vertex/index buffer and handed to SDL_RenderGeometry in as few calls as
+// possible. The batch is flushed when the texture changes, when it hits
+// HL_BATCH_MAX_VERTS, or when the caller needs to interleave other draws.
+#define HL_BATCH_MAX_VERTS 65536
+
+typedef struct {
+    SDL_Vertex*  verts;
+    int*         indices;
+    int          vert_count;
+    int          vert_cap;
+    int          index_count;
+    int          index_cap;
+    SDL_Texture* texture;   // texture bound to the pending vertices (NULL = untextured)
+} HL_Batch;
+
+static HL_Batch   g_batch = {0};
+static SDL_FPoint* g_screen_pos = NULL;  // per-tile screen centers for the current frame
+static int        g_screen_pos_cap = 0;
+
+static void batch_flush(void) {
+    if (g_batch.vert_count == 0) return;
+#if SDL_VERSION_ATLEAST(2,0,18)
+    SDL_RenderGeometry(g_renderer, g_batch.texture, g_batch.verts, g_batch.vert_count,
+                       g_batch.indices, g_batch.index_count);
+    HL_STAT_ADD(geometry_calls, 1);
+#else
+    // Fallback: just outline the triangles (older SDL2)
+    for (int i = 0; i + 2 < g_batch.index_count; i += 3) {
+        const SDL_Vertex* a = &g_batch.verts[g_batch.indices[i]];
+        const SDL_Vertex* b = &g_batch.verts[g_batch.indices[i+1]];
+        const SDL_Vertex* d = &g_batch.verts[g_batch.indices[i+2]];
+        SDL_SetRenderDrawColor(g_renderer, a->color.r, a->color.g, a->color.b, a->color.a);
+        SDL_RenderDrawLineF(g_renderer, a->position.x, a->position.y, b->position.x, b->position.y);
+        SDL_RenderDrawLineF(g_renderer, b->position.x, b->position.y, d->position.x, d->position.y);
+        SDL_RenderDrawLineF(g_renderer, d->position.x, d->position.y, a->position.x, a->position.y);
+    }
+#endif
+    g_batch.vert_count = 0;
+    g_batch.index_count = 0;
+}
+
+// Make room for n_verts/n_indices more entries drawn with `texture`.
+// Returns the index of the first new vertex, or -1 if memory ran out.
+static int batch_reserve(SDL_Texture* texture, int n_verts, int n_indices) {
+    if (texture != g_batch.texture) {
+        batch_flush();
+        g_batch.texture = texture;
+    }
+    if (g_batch.vert_count + n_verts > HL_BATCH_MAX_VERTS) {
+        batch_flush();
+    }
+    if (g_batch.vert_count + n_verts > g_batch.vert_cap) {
+        int cap = g_batch.vert_cap ? g_batch.vert_cap * 2 : 1024;
+        while (cap < g_batch.vert_count + n_verts) cap *= 2;
+        SDL_Vertex* verts = (SDL_Vertex*)heap_realloc(g_batch.verts, sizeof(SDL_Vertex) * cap);
+        if (!verts) return -1;
+        g_batch.verts = verts;
+        g_batch.vert_cap = cap;
+    }
+    if (g_batch.index_count + n_indices > g_batch.index_cap) {
+        int cap = g_batch.index_cap ? g_batch.index_cap * 2 : 2048;
+        while (cap < g_batch.index_count + n_indices) cap *= 2;
+        int* indices = (int*)heap_realloc(g_batch.indices, sizeof(int) * cap);
+        if (!indices) return -1;
+        g_batch.indices = indices;
+        g_batch.index_cap = cap;
+    }
+    return g_batch.vert_count;
+}
+
+static void batch_free(void) {
+    free(g_batch.verts);
+    free(g_batch.indices);
+    memset(&g_batch, 0, sizeof(g_batch));
+    free(g_screen_pos);
+    g_screen_pos = NULL;
+    g_screen_pos_cap = 0;
+}
+
+// Draw list storage (see Draw list below)
+#define HL_KEY_LAYER_SHIFT   56
+#define HL_KEY_TEXTURE_SHIFT 40
+#define HL_KEY_BLEND_SHIFT   32
+
+enum { HL_DRAW_TERRAIN, HL_DRAW_OVERLAY, HL_DRAW_UNIT, HL_DRAW_FOG };  // layer field of the key
+#define HL_DRAW_FILL -2  // HL_DrawOp slot of an untextured hex without outline
+
+typedef struct {
+    uint64_t key;
+    uint32_t op;       // index into g_draw_ops
+    uint32_t pad;
+} HL_DrawCmd;
+
+typedef struct {
+    SDL_FRect dest;    // sprite rectangle; hexes keep their center in x, y
+    int       slot;    // texture slot, -1 for an untextured hex, or HL_DRAW_FILL
+    SDL_Color color;
+} HL_DrawOp;
+
+static HL_DrawCmd* g_draw_cmds = NULL;
+static HL_DrawCmd* g_draw_sorted = NULL;  // radix sort scratch
+static HL_DrawOp*  g_draw_ops = NULL;
+static int         g_draw_count = 0;
+static int         g_draw_cap = 0;
+static uint32_t    g_layers = HL_LAYER_ALL;  // hl_set_visible_layers
+
+static int draw_list_reserve(int count) {
+    if (count <= g_draw_cap) return 1;
+    int cap = g_draw_cap ? g_draw_cap : 1024;
+    while (cap < count) cap *= 2;
+    HL_DrawCmd* cmds = (HL_DrawCmd*)heap_realloc(g_draw_cmds, sizeof(HL_DrawCmd) * cap);
+    if (!cmds) return 0;
+    g_draw_cmds = cmds;
+    HL_DrawCmd* sorted = (HL_DrawCmd*)heap_realloc(g_draw_sorted, sizeof(HL_DrawCmd) * cap);
+    if (!sorted) return 0;
+    g_draw_sorted = sorted;
+    HL_DrawOp* ops = (HL_DrawOp*)heap_realloc(g_draw_ops, sizeof(HL_DrawOp) * cap);
+    if (!ops) return 0;
+    g_draw_ops = ops;
+    g_draw_cap = cap;
+    return 1;
+}
+
+static void draw_list_free(void) {
+    free(g_draw_cmds);
+    free(g_draw_sorted);
+    free(g_draw_ops);
+    g_draw_cmds = g_draw_sorted = NULL;
+    g_draw_ops = NULL;
+    g_draw_count = g_draw_cap = 0;
+}
+
+// Filled hex as an indexed fan: 6 vertices, 4 triangles.
+static void batch_hex_fill(float cx, float cy, SDL_Color c) {
+    int base = batch_reserve(NULL, 6, 12);
+    if (base < 0) return;
+    SDL_Vertex* v = &g_batch.verts[base];
+    for (int i = 0; i < 6; ++i) {
+        v[i].position.x = cx + g_corner_fill[i].x;
+        v[i].position.y = cy + g_corner_fill[i].y;
+        v[i].color = c;
+        v[i].tex_coord.x = 0.0f;
+        v[i].tex_coord.y = 0.0f;
+    }
+    int* idx = &g_batch.indices[g_batch.index_count];
+    for (int t = 0; t < 4; ++t) {
+        idx[t*3 + 0] = base;
+        idx[t*3 + 1] = base + t + 1;
+        idx[t*3 + 2] = base + t + 2;
+    }
+    g_batch.vert_count += 6;
+    g_batch.index_count += 12;
+}
+
+// Hex outline as a ring of six quads sharing their corners: 12 vertices, 12 triangles.
+static void batch_hex_outline(float cx, float cy, SDL_Color c) {
+    int base = batch_reserve(NULL, 12, 36);
+    if (base < 0) return;
+    SDL_Vertex* v = &g_batch.verts[base];
+    for (int i = 0; i < 6; ++i) {
+        v[i].position.x = cx + g_corner_outer[i].x;
+        v[i].position.y = cy + g_corner_outer[i].y;
+        v[i+6].position.x = cx + g_corner_inner[i].x;
+        v[i+6].position.y = cy + g_corner_inner[i].y;
+        v[i].color = c;
+        v[i+6].color = c;
+        v[i].tex_coord.x = v[i].tex_coord.y = 0.0f;
+        v[i+6].tex_coord.x = v[i+6].tex_coord.y = 0.0f;
+    }
+    int* idx = &g_batch.indices[g_batch.index_count];
+    for (int i = 0; i < 6; ++i) {
+        int n = (i + 1) % 6;
+        idx[i*6 + 0] = base + i;
+        idx[i*6 + 1] = base + n;
+        idx[i*6 + 2] = base + 6 + i;
+        idx[i*6 + 3] = base + n;
+        idx[i*6 + 4] = base + 6 + n;
+        idx[i*6 + 5] = base + 6 + i;
+    }
+    g_batch.vert_count += 12;
+    g_batch.index_count += 36;
+}
+
+static void batch_hex(float cx, float cy, SDL_Color c) {
+    static const SDL_Color outline = { 0, 0, 0, 200 };
+    batch_hex_fill(cx, cy, c);
+    batch_hex_outline(cx, cy, outline);
+}
+
+// Textured quad with corners p[0..3] clockwise from the one mapped to (u0, v0)
+static void batch_quad_points(SDL_Texture* texture, const SDL_FPoint p[4], float u0, float v0, float u1, float v1, SDL_Color c) {
+    int base = batch_reserve(texture, 4, 6);
+    if (base < 0) return;
+    SDL_Vertex* v = &g_batch.verts[base];
+    for (int i = 0; i < 4; ++i) {
+        v[i].position = p[i];
+        v[i].color = c;
+    }
+    v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+    v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+    v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+    v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+    int* idx = &g_batch.indices[g_batch.index_count];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+    g_batch.vert_count += 4;
+    g_batch.index_count += 6;
+}
+
+// Textured quad covering `dest`, sampling the [u0,u1]x[v0,v1] sub-rect of `texture`
+static void batch_quad(SDL_Texture* texture, const SDL_FRect* dest, float u0, float v0, float u1, float v1, SDL_Color c) {
+    SDL_FPoint p[4] = {
+        { dest->x, dest->y }, { dest->x + dest->w, dest->y },
+        { dest->x + dest->w, dest->y + dest->h }, { dest->x, dest->y + dest->h },
+    };
+    batch_quad_points(texture, p, u0, v0, u1, v1, c);
+}
+
+static void screen_to_world_sized(float* px, float* py, int w, int h) {
+    float zoom = g_camera_zoom;
+    if (zoom < 0.05f) zoom = 0.05f;
+    float x = *px;
+    float y = *py;
+    x = (x - w * 0.5f) / zoom + w * 0.5f;
+    y = (y - h * 0.5f) / zoom + h * 0.5f;
+    x -= g_camera_offset_x;
+    y -= g_camera_offset_y;
+    *px = x;
+    *py = y;
+}
+
+static void screen_to_world(float* px, float* py) {
+    screen_to_world_sized(px, py, g_output_w, g_output_h);
+}
+
+static void world_to_screen(float* px, float* py, int win_w, int win_h) {
+    float zoom = g_camera_zoom;
+    if (zoom < 0.05f) zoom = 0.05f;
+    float x = *px + g_camera_offset_x;
+    float y = *py + g_camera_offset_y;
+    x = (x - win_w * 0.5f) * zoom + win_w * 0.5f;
+    y = (y - win_h * 0.5f) * zoom + win_h * 0.5f;
+    *px = x;
+    *py = y;
+}
+
+// --- Spatial index ---
+// Submitted hexes are bucketed into HL_CHUNK_SIZE x HL_CHUNK_SIZE axial
+// chunks. Each bucket owns a contiguous run of `order`, so a frame only walks
+// the chunks overlapping the camera rectangle and never the whole map.
+#define HL_CHUNK_SHIFT 3
+#define HL_CHUNK_SIZE  (1 << HL_CHUNK_SHIFT)
+
+typedef struct {
+    int32_t cq, cr;   // chunk coordinates
+    int     start;    // first entry in HL_SpatialIndex.order
+    int     count;    // 0 marks an empty hash slot
+} HL_ChunkBucket;
+
+typedef struct {
+    HL_ChunkBucket* buckets;    // open-addressed table keyed on (cq, cr)
+    int     bucket_cap;         // power of two
+    int     bucket_used;
+    int*    order;              // item indices grouped by chunk (submission order within a chunk)
+    int     order_cap;
+    int     item_count;         // used length of `order`; in-place tile edits can leave gaps
+    int32_t cq_min, cq_max, cr_min, cr_max;
+    int     dirty;
+} HL_SpatialIndex;
+
+static HL_SpatialIndex g_tile_index = {0};
+static HL_SpatialIndex g_instance_index = {0};
+static HL_SpatialIndex g_label_index = {0};
+static int*            g_visible = NULL;   // item indices that survived culling this pass
+static int             g_visible_cap = 0;
+static int*            g_visible_chunks = NULL;  // bucket indices that survived culling
+static int             g_visible_chunks_cap = 0;
+
+static int32_t chunk_coord(int32_t v) {
+    return v >= 0 ? v / HL_CHUNK_SIZE : -((-v - 1) / HL_CHUNK_SIZE) - 1;
+}
+
+static uint32_t axial_hash(int32_t q, int32_t r) {
+    uint32_t h = (uint32_t)q * 0x9E3779B1u ^ (uint32_t)r * 0x85EBCA77u;
+    return h ^ (h >> 15);
+}
+
+static HL_ChunkBucket* spatial_find(const HL_SpatialIndex* idx, int32_t cq, int32_t cr) {
+    if (!idx->buckets) return NULL;
+    uint32_t mask = (uint32_t)idx->bucket_cap - 1;
+    for (uint32_t i = axial_hash(cq, cr) & mask;; i = (i + 1) & mask) {
+        HL_ChunkBucket* b = &idx->buckets[i];
+        if (b->count == 0) return NULL;
+        if (b->cq == cq && b->cr == cr) return b;
+    }
+}
+
+static int spatial_grow(HL_SpatialIndex* idx) {
+    int cap = idx->bucket_cap ? idx->bucket_cap * 2 : 64;
+    HL_ChunkBucket* buckets = (HL_ChunkBucket*)heap_calloc((size_t)cap, sizeof(HL_ChunkBucket));
+    if (!buckets) return 0;
+    uint32_t mask = (uint32_t)cap - 1;
+    for (int i = 0; i < idx->bucket_cap; ++i) {
+        HL_ChunkBucket* b = &idx->buckets[i];
+        if (b->count == 0) continue;
+        uint32_t j = axial_hash(b->cq, b->cr) & mask;
+        while (buckets[j].count != 0) j = (j + 1) & mask;
+        buckets[j] = *b;
+    }
+    free(idx->buckets);
+    idx->buckets = buckets;
+    idx->bucket_cap = cap;
+    return 1;
+}
+
+// Widen the chunk bounds to take in a new bucket at (cq, cr)
+static void spatial_extend(HL_SpatialIndex* idx, int32_t cq, int32_t cr) {
+    if (idx->bucket_used == 0) {
+        idx->cq_min = idx->cq_max = cq;
+        idx->cr_min = idx->cr_max = cr;
+        return;
+    }
+    if (cq < idx->cq_min) idx->cq_min = cq;
+    if (cq > idx->cq_max) idx->cq_max = cq;
+    if (cr < idx->cr_min) idx->cr_min = cr;
+    if (cr > idx->cr_max) idx->cr_max = cr;
+}
+
+// Drop the emptied bucket in `slot` with a backward shift, like
+// tile_lookup_remove. `moved(from, to)` hears about every bucket that changes slot.
+static void spatial_remove_bucket(HL_SpatialIndex* idx, int slot, void (*moved)(int from, int to)) {
+    uint32_t mask = (uint32_t)idx->bucket_cap - 1;
+    uint32_t hole = (uint32_t)slot;
+    for (uint32_t j = (hole + 1) & mask; idx->buckets[j].count != 0; j = (j + 1) & mask) {
+        uint32_t home = axial_hash(idx->buckets[j].cq, idx->buckets[j].cr) & mask;
+        int stays = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!stays) {
+            idx->buckets[hole] = idx->buckets[j];
+            if (moved) moved((int)j, (int)hole);
+            hole = j;
+        }
+    }
+    memset(&idx->buckets[hole], 0, sizeof(HL_ChunkBucket));
+    idx->bucket_used--;
+}
+
+// Rebuild the index over `count` records laid out `stride` bytes apart, each
+// starting with int32 q, r (HL_HexInstance, HL_TileInstance, HL_DebugLabel).
+static void spatial_build(HL_SpatialIndex* idx, const void* items, size_t stride, int count) {
+    idx->dirty = 0;
+    idx->item_count = 0;
+    idx->bucket_used = 0;
+    if (idx->buckets) memset(idx->buckets, 0, sizeof(HL_ChunkBucket) * idx->bucket_cap);
+    if (!items || count <= 0) return;
+    if (idx->order_cap < count) {
+        int* order = (int*)heap_realloc(idx->order, sizeof(int) * count);
+        if (!order) return;
+        idx->order = order;
+        idx->order_cap = count;
+    }
+
+    const uint8_t* base = (const uint8_t*)items;
+    // Pass 1: count items per chunk
+    for (int i = 0; i < count; ++i) {
+        const int32_t* qr = (const int32_t*)(base + stride * (size_t)i);
+        int32_t cq = chunk_coord(qr[0]);
+        int32_t cr = chunk_coord(qr[1]);
+        if ((idx->bucket_used + 1) * 2 > idx->bucket_cap && !spatial_grow(idx)) return;
+        uint32_t mask = (uint32_t)idx->bucket_cap - 1;
+        uint32_t j = axial_hash(cq, cr) & mask;
+        while (idx->buckets[j].count != 0 && (idx->buckets[j].cq != cq || idx->buckets[j].cr != cr)) {
+            j = (j + 1) & mask;
+        }
+        HL_ChunkBucket* b = &idx->buckets[j];
+        if (b->count == 0) {
+            b->cq = cq;
+            b->cr = cr;
+            spatial_extend(idx, cq, cr);
+            idx->bucket_used++;
+        }
+        b->count++;
+    }
+    // Pass 2: prefix sums (start doubles as the fill cursor for pass 3)
+    int offset = 0;
+    for (int i = 0; i < idx->bucket_cap; ++i) {
+        HL_ChunkBucket* b = &idx->buckets[i];
+        if (b->count == 0) continue;
+        b->start = offset;
+        offset += b->count;
+    }
+    // Pass 3: scatter, keeping submission order inside each chunk
+    for (int i = 0; i < count; ++i) {
+        const int32_t* qr = (const int32_t*)(base + stride * (size_t)i);
+        HL_ChunkBucket* b = spatial_find(idx, chunk_coord(qr[0]), chunk_coord(qr[1]));
+        idx->order[b->start++] = i;
+    }
+    for (int i = 0; i < idx->bucket_cap; ++i) {
+        HL_ChunkBucket* b = &idx->buckets[i];
+        if (b->count) b->start -= b->count;
+    }
+    idx->item_count = count;
+}
+
+static void spatial_free(HL_SpatialIndex* idx) {
+    free(idx->buckets);
+    free(idx->order);
+    memset(idx, 0, sizeof(*idx));
+}
+
+// Camera rectangle in world space, grown by `margin` plus one hex, inverted
+// into axial terms: the visible q columns, and per chunk column the chunk
+// rows that can overlap the screen. `margin` is the world-space distance an
+// item may reach beyond its hex center (sprite overhang, offsets).
+typedef struct {
+    float   x0, y0, x1, y1;  // rectangle relative to the grid origin, in hex sizes
+    int32_t q_lo, q_hi;
+} HL_ViewRange;
+
+static void view_range(HL_ViewRange* v, int win_w, int win_h, float margin) {
+    float x0 = 0.0f, y0 = 0.0f;
+    float x1 = (float)win_w, y1 = (float)win_h;
+    screen_to_world_sized(&x0, &y0, win_w, win_h);
+    screen_to_world_sized(&x1, &y1, win_w, win_h);
+    float pad = margin + g_grid.size;
+    v->x0 = (x0 - pad - g_grid.origin_x) / g_grid.size;
+    v->x1 = (x1 + pad - g_grid.origin_x) / g_grid.size;
+    v->y0 = (y0 - pad - g_grid.origin_y) / g_grid.size;
+    v->y1 = (y1 + pad - g_grid.origin_y) / g_grid.size;
+    // q = b0*x + b1*y is extreme at opposite corners of the rectangle
+    const HL_Orientation* o = g_orient;
+    float q_min = o->b0 * (o->b0 >= 0.0f ? v->x0 : v->x1) + o->b1 * (o->b1 >= 0.0f ? v->y0 : v->y1);
+    float q_max = o->b0 * (o->b0 >= 0.0f ? v->x1 : v->x0) + o->b1 * (o->b1 >= 0.0f ? v->y1 : v->y0);
+    v->q_lo = (int32_t)floorf(q_min);
+    v->q_hi = (int32_t)ceilf(q_max);
+}
+
+static void view_chunk_rows(const HL_ViewRange* v, int32_t cq, int32_t* cr_lo, int32_t* cr_hi) {
+    // q span of this chunk column, clipped to the visible columns
+    int32_t qa = cq * HL_CHUNK_SIZE, qb = qa + HL_CHUNK_SIZE - 1;
+    if (qa < v->q_lo) qa = v->q_lo;
+    if (qb > v->q_hi) qb = v->q_hi;
+    // Both orientations have f0, f3 > 0 and f1, f2 >= 0: solve each axis for r
+    const HL_Orientation* o = g_orient;
+    float r_lo = (v->y0 - o->f2 * qb) / o->f3;
+    float r_hi = (v->y1 - o->f2 * qa) / o->f3;
+    if (o->f1 > 0.0f) {
+        r_lo = fmaxf(r_lo, (v->x0 - o->f0 * qb) / o->f1);
+        r_hi = fminf(r_hi, (v->x1 - o->f0 * qa) / o->f1);
+    }
+    *cr_lo = chunk_coord((int32_t)floorf(r_lo));
+    *cr_hi = chunk_coord((int32_t)ceilf(r_hi));
+}
+
+// Collect the buckets of every chunk that can overlap the screen into
+// g_visible_chunks (as indices into idx->buckets). Returns the number of
+// chunks collected.
+static int spatial_query_chunks(const HL_SpatialIndex* idx, int win_w, int win_h, float margin) {
+    if (idx->item_count == 0 || g_grid.size <= 0.0f) return 0;
+    if (g_visible_chunks_cap < idx->bucket_used) {
+        int* chunks = (int*)heap_realloc(g_visible_chunks, sizeof(int) * idx->bucket_used);
+        if (!chunks) return 0;
+        g_visible_chunks = chunks;
+        g_visible_chunks_cap = idx->bucket_used;
+    }
+
+    HL_ViewRange view;
+    view_range(&view, win_w, win_h, margin);
+    int32_t cq_lo = chunk_coord(view.q_lo), cq_hi = chunk_coord(view.q_hi);
+    if (cq_lo < idx->cq_min) cq_lo = idx->cq_min;
+    if (cq_hi > idx->cq_max) cq_hi = idx->cq_max;
+
+    int n = 0;
+    for (int32_t cq = cq_lo; cq <= cq_hi; ++cq) {
+        int32_t cr_lo, cr_hi;
+        view_chunk_rows(&view, cq, &cr_lo, &cr_hi);
+        if (cr_lo < idx->cr_min) cr_lo = idx->cr_min;
+        if (cr_hi > idx->cr_max) cr_hi = idx->cr_max;
+        for (int32_t cr = cr_lo; cr <= cr_hi; ++cr) {
+            const HL_ChunkBucket* b = spatial_find(idx, cq, cr);
+            if (!b) continue;
+            g_visible_chunks[n++] = (int)(b - idx->buckets);
+        }
+    }
+    return n;
+}
+
+// Make room for `count` entries in g_visible
+static int visible_reserve(int count) {
+    if (g_visible_cap >= count) return 1;
+    int* visible = (int*)heap_realloc(g_visible, sizeof(int) * count);
+    if (!visible) return 0;
+    g_visible = visible;
+    g_visible_cap = count;
+    return 1;
+}
+
+// Collect the items of every chunk that can overlap the screen into
+// g_visible. Returns the number collected.
+static int spatial_query(const HL_SpatialIndex* idx, int win_w, int win_h, float margin) {
+    if (!visible_reserve(idx->item_count)) return 0;
+    int chunks = spatial_query_chunks(idx, win_w, win_h, margin);
+    int n = 0;
+    for (int c = 0; c < chunks; ++c) {
+        const HL_ChunkBucket* b = &idx->buckets[g_visible_chunks[c]];
+        memcpy(&g_visible[n], &idx->order[b->start], sizeof(int) * b->count);
+        n += b->count;
+    }
+    return n;
+}
+
+// Largest height/width ratio among loaded textures (sprites are fitted to the
+// hex width, so tall art is what reaches furthest beyond a hex).
+static float max_texture_aspect(void) {
+    float aspect = 1.0f;
+    for (int i = 0; i < HL_MAX_TEXTURE_SLOTS; ++i) {
+        if (!g_textures[i].texture || g_textures[i].w <= 0) continue;
+        float a = (float)g_textures[i].h / (float)g_textures[i].w;
+        if (a > aspect) aspect = a;
+    }
+    return aspect;
+}
+
+typedef struct {
+    uint8_t rows[5];
+} Glyph3x5;
+
+static const Glyph3x5 glyph_digits[10] = {
+    {{0b111,0b101,0b101,0b101,0b111}}, // 0
+    {{0b010,0b110,0b010,0b010,0b111}}, // 1
+    {{0b111,0b001,0b111,0b100,0b111}}, // 2
+    {{0b111,0b001,0b111,0b001,0b111}}, // 3
+    {{0b101,0b101,0b111,0b001,0b001}}, // 4
+    {{0b111,0b100,0b111,0b001,0b111}}, // 5
+    {{0b111,0b100,0b111,0b101,0b111}}, // 6
+    {{0b111,0b001,0b010,0b010,0b010}}, // 7
+    {{0b111,0b101,0b111,0b101,0b111}}, // 8
+    {{0b111,0b101,0b111,0b001,0b111}}, // 9
+};
+static const Glyph3x5 glyph_minus = { {0b000,0b000,0b111,0b000,0b000} };
+static const Glyph3x5 glyph_comma = { {0b000,0b000,0b000,0b010,0b100} };
+
+// The glyphs are baked side by side into one small texture at init, so a
+// label is a row of textured quads in the shared geometry batch. Each glyph
+// cell is 4 texels wide; the empty column keeps neighbours from bleeding.
+#define HL_FONT_GLYPHS 12  // digits, '-', ','
+#define HL_FONT_CELL_W 4
+static SDL_Texture* g_font_texture = NULL;
+
+static int glyph_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c == '-') return 10;
+    if (c == ',') return 11;
+    return -1;
+}
+
+static const Glyph3x5* glyph_at(int index) {
+    if (index < 10) return &glyph_digits[index];
+    return index == 10 ? &glyph_minus : &glyph_comma;
+}
+
+static void font_create(void) {
+#if SDL_VERSION_ATLEAST(2,0,18)
+    uint8_t pixels[5][HL_FONT_GLYPHS * HL_FONT_CELL_W][4];
+    memset(pixels, 0, sizeof(pixels));
+    for (int g = 0; g < HL_FONT_GLYPHS; ++g) {
+        const Glyph3x5* glyph = glyph_at(g);
+        for (int row = 0; row < 5; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                if (glyph->rows[row] & (1 << (2 - col))) memset(pixels[row][g * HL_FONT_CELL_W + col], 255, 4);
+            }
+        }
+    }
+    SDL_Texture* tex = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                         HL_FONT_GLYPHS * HL_FONT_CELL_W, 5);
+    if (!tex || SDL_UpdateTexture(tex, NULL, pixels, (int)sizeof(pixels[0])) != 0) {
+        // Labels fall back to one FillRect per lit pixel
+        SDL_Log("Label font texture creation failed: %s", SDL_GetError());
+        if (tex) SDL_DestroyTexture(tex);
+        return;
+    }
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(tex, SDL_ScaleModeNearest);
+    g_font_texture = tex;
+#endif
+}
+
+static void draw_glyph(SDL_Renderer* renderer, float x, float y, float scale, const Glyph3x5* glyph) {
+    for (int row = 0; row < 5; ++row) {
+        uint8_t bits = glyph->rows[row];
+        for (int col = 0; col < 3; ++col) {
+            if (bits & (1 << (2 - col))) {
+                SDL_FRect rect = { x + col * scale, y + row * scale, scale, scale };
+                SDL_RenderFillRectF(renderer, &rect);
+                HL_STAT_ADD(fill_calls, 1);
+            }
+        }
+    }
+}
+
+// Queues the label into the geometry batch (the caller flushes) or, without
+// the font texture, draws it immediately
+static void draw_label(SDL_Renderer* renderer, float cx, float cy, const char* text, float base_scale) {
+    if (!text || !*text) return;
+    size_t len = strlen(text);
+    if (len == 0) return;
+    float char_w = 3.0f * base_scale;
+    float spacing = base_scale;
+    float text_w = len * char_w + (len - 1) * spacing;
+    float text_h = 5.0f * base_scale;
+    float x = cx - text_w * 0.5f;
+    float y = cy - text_h * 0.5f;
+    SDL_Color color = { 245, 245, 245, 255 };
+    if (!g_font_texture) SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    const float texel = 1.0f / (HL_FONT_GLYPHS * HL_FONT_CELL_W);
+    for (size_t i = 0; i < len; ++i, x += char_w + spacing) {
+        int g = glyph_index(text[i]);
+        if (g < 0) continue;
+        if (g_font_texture) {
+            SDL_FRect dest = { x, y, char_w, text_h };
+            float u0 = (float)(g * HL_FONT_CELL_W) * texel;
+            batch_quad(g_font_texture, &dest, u0, 0.0f, u0 + 3.0f * texel, 1.0f, color);
+        } else {
+            draw_glyph(renderer, x, y, base_scale, glyph_at(g));
+        }
+    }
+}
+
+// --- Render thread ---
+// With HL_INIT_ASYNC_PRESENT every SDL video call (window, renderer, event
+// pump, present) is made on one thread owned by hexlib. hl_step hands the
+// frame to that thread and waits while the frame is built, so nothing the
+// build reads changes under it; the build is not overlapped with the caller. The present, including any vsync wait, then
+// runs while the caller works on the next frame. Public calls that touch the
+// renderer are forwarded with render_call and run after that present. Between
+// frames the thread pumps window events every HL_RENDER_PUMP_MS.
+#define HL_RENDER_PUMP_MS 4
+
+typedef void (*HL_RenderFn)(void* arg);
+
+// Arguments and result of a public call forwarded to the render thread
+typedef struct {
+    int         a, b;
+    uint32_t    flags;
+    void*       p;
+    const char* str;
+    int         result;
+} HL_RenderCall;
+
+static SDL_Thread*  g_render_thread = NULL;
+static SDL_threadID g_render_thread_id = 0;
+static SDL_sem*     g_render_go = NULL;        // posted when g_render_fn is set
+static SDL_sem*     g_render_done = NULL;      // posted when it has returned
+static HL_RenderFn  g_render_fn = NULL;        // NULL stops the thread
+static void*        g_render_arg = NULL;
+static int          g_render_present = 0;      // set by a frame: present after releasing the caller
+static Uint64       g_render_present_ticks = 0;  // length of the last threaded present (stats builds)
+static SDL_sem*     g_render_wake = NULL;      // posted when events arrive during hl_wait_event_timeout
+static SDL_atomic_t g_render_waiting;          // 1 while the caller sleeps in hl_wait_event_timeout
+
+// 1 if the calling thread must forward renderer work
+static int render_elsewhere(void) {
+    return g_render_thread && SDL_ThreadID() != g_render_thread_id;
+}
+
+// Run fn(arg) on the render thread and wait for it to return
+static void render_call(HL_RenderFn fn, void* arg) {
+    if (!render_elsewhere()) {
+        fn(arg);
+        return;
+    }
+    g_render_fn = fn;
+    g_render_arg = arg;
+    SDL_SemPost(g_render_go);
+    SDL_SemWait(g_render_done);
+}
+
+// Pump window events and wake a caller waiting for them
+static void render_pump(void) {
+    if (g_window) SDL_PumpEvents();
+    if (SDL_AtomicGet(&g_render_waiting) && SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT)) SDL_SemPost(g_render_wake);
+}
+
+static int SDLCALL render_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        if (SDL_SemWaitTimeout(g_render_go, HL_RENDER_PUMP_MS) != 0) {
+            render_pump();
+            continue;
+        }
+        if (!g_render_fn) break;
+        g_render_fn(g_render_arg);
+        int present = g_render_present;
+        g_render_present = 0;
+        SDL_SemPost(g_render_done);
+        if (present) {
+            Uint64 t = HL_STAT_NOW();
+            SDL_RenderPresent(g_renderer);
+            g_render_present_ticks = HL_STAT_NOW() - t;
+        }
+        render_pump();
+    }
+    return 0;
+}
+
+static void render_stop(void) {
+    if (g_render_thread) {
+        g_render_fn = NULL;
+        SDL_SemPost(g_render_go);
+        SDL_WaitThread(g_render_thread, NULL);
+        g_render_thread = NULL;
+    }
+    if (g_render_go) { SDL_DestroySemaphore(g_render_go); g_render_go = NULL; }
+    if (g_render_done) { SDL_DestroySemaphore(g_render_done); g_render_done = NULL; }
+    if (g_render_wake) { SDL_DestroySemaphore(g_render_wake); g_render_wake = NULL; }
+    g_render_thread_id = 0;
+}
+
+static int render_start(void) {
+    g_render_go = SDL_CreateSemaphore(0);
+    g_render_done = SDL_CreateSemaphore(0);
+    g_render_wake = SDL_CreateSemaphore(0);
+    if (g_render_go && g_render_done && g_render_wake) g_render_thread = SDL_CreateThread(render_thread, "hexlib-render", NULL);
+    if (!g_render_thread) {
+        SDL_Log("Render thread failed: %s", SDL_GetError());
+        render_stop();
+        return 0;
+    }
+    g_render_thread_id = SDL_GetThreadID(g_render_thread);
+    return 1;
+}
+
+static void init_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_init_ex(c->a, c->b, c->str, c->flags);
+}
+
+HEXLIB_API int hl_init(int width, int height, const char* title) {
+    return hl_init_ex(width, height, title, 0);
+}
+
+HEXLIB_API int hl_init_ex(int width, int height, const char* title, uint32_t flags) {
+    if (flags & HL_INIT_ASYNC_PRESENT) {
+        flags &= ~HL_INIT_ASYNC_PRESENT;
+        int threaded = 1;
+#ifdef __APPLE__
+        // Cocoa windows can only be created and pumped on the main thread
+        if (!(flags & HL_INIT_HEADLESS)) {
+            SDL_Log("HL_INIT_ASYNC_PRESENT is headless-only on macOS; rendering on the calling thread");
+            threaded = 0;
+        }
+#endif
+        if (threaded && (g_render_thread || render_start())) {
+            HL_RenderCall c = { width, height, flags, NULL, title, 0 };
+            render_call(init_call, &c);
+            if (!c.result) render_stop();
+            return c.result;
+        }
+    }
+    stats_reset();
+    int headless = (flags & HL_INIT_HEADLESS) != 0;
+    // Headless mode never touches the video subsystem, so it needs no display
+    Uint32 subsystems = headless ? SDL_INIT_EVENTS : (SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+    if (SDL_Init(subsystems) != 0) {
+        SDL_Log("SDL_Init failed: %s", SDL_GetError());
+        return 0;
+    }
+
+    if (headless) {
+        g_offscreen = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!g_offscreen) {
+            SDL_Log("Offscreen surface failed: %s", SDL_GetError());
+            SDL_Quit();
+            return 0;
+        }
+        g_renderer = SDL_CreateSoftwareRenderer(g_offscreen);
+        if (!g_renderer) {
+            SDL_Log("CreateSoftwareRenderer failed: %s", SDL_GetError());
+            SDL_FreeSurface(g_offscreen);
+            g_offscreen = NULL;
+            SDL_Quit();
+            return 0;
+        }
+    } else {
+        // SDL_HINT_RENDER_DRIVER can be set if you prefer "opengl", "metal", etc.
+        g_window = SDL_CreateWindow(
+            title ? title : "HexLib",
+            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            width, height,
+            SDL_WINDOW_SHOWN
+        );
+        if (!g_window) {
+            SDL_Log("CreateWindow failed: %s", SDL_GetError());
+            SDL_Quit();
+            return 0;
+        }
+
+        // SDL_Renderer with geometry support (SDL 2.0.18+)
+        Uint32 renderer_flags = (flags & HL_INIT_SOFTWARE) ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+        if (!(flags & HL_INIT_NO_VSYNC)) renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+        g_renderer = SDL_CreateRenderer(g_window, -1, renderer_flags);
+        if (!g_renderer) {
+            SDL_Log("CreateRenderer failed: %s", SDL_GetError());
+            SDL_DestroyWindow(g_window);
+            g_window = NULL;
+            SDL_Quit();
+            return 0;
+        }
+    }
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+    scene_damage_all();
+    g_output_w = width;
+    g_output_h = height;
+    if (g_window) SDL_GetWindowSize(g_window, &g_output_w, &g_output_h);
+
+    int img_flags = IMG_INIT_PNG | IMG_INIT_JPG;
+    int img_init = IMG_Init(img_flags);
+    if ((img_init & img_flags) != img_flags) {
+        SDL_Log("IMG_Init warning: %s", IMG_GetError());
+    }
+    font_create();
+    return 1;
+}
+
+HEXLIB_API void hl_get_output_size(int* out_w, int* out_h) {
+    if (out_w) *out_w = g_output_w;
+    if (out_h) *out_h = g_output_h;
+}
+
+static void read_pixels_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_read_pixels(c->p, c->a);
+}
+
+HEXLIB_API int hl_read_pixels(void* pixels, int pitch) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { pitch, 0, 0, pixels, NULL, 0 };
+        render_call(read_pixels_call, &c);
+        return c.result;
+    }
+    if (!g_renderer || !pixels) return 0;
+    if (g_offscreen) {
+        // The software renderer draws straight into the surface, which still
+        // holds the last frame presented
+        int row = g_offscreen->w * 4;
+        if (pitch < row) return 0;
+        if (SDL_MUSTLOCK(g_offscreen)) SDL_LockSurface(g_offscreen);
+        for (int y = 0; y < g_offscreen->h; ++y) {
+            memcpy((uint8_t*)pixels + (size_t)y * pitch,
+                   (const uint8_t*)g_offscreen->pixels + (size_t)y * g_offscreen->pitch, (size_t)row);
+        }
+        if (SDL_MUSTLOCK(g_offscreen)) SDL_UnlockSurface(g_offscreen);
+        return 1;
+    }
+    int w = 0, h = 0;
+    if (SDL_GetRendererOutputSize(g_renderer, &w, &h) != 0 || pitch < w * 4) return 0;
+    // The window's buffer is undefined after a present; the back buffer
+    // still holds the last frame
+    int from_back = g_backbuffer && g_backbuffer_valid && g_backbuffer_w == w && g_backbuffer_h == h;
+    if (from_back) SDL_SetRenderTarget(g_renderer, g_backbuffer);
+    int ok = SDL_RenderReadPixels(g_renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels, pitch) == 0;
+    if (from_back) SDL_SetRenderTarget(g_renderer, NULL);
+    if (!ok) {
+        SDL_Log("RenderReadPixels failed: %s", SDL_GetError());
+        return 0;
+    }
+    return 1;
+}
+
+static void shutdown_call(void* arg) {
+    (void)arg;
+    hl_shutdown();
+}
+
+HEXLIB_API void hl_shutdown(void) {
+    if (render_elsewhere()) {
+        render_call(shutdown_call, NULL);
+        render_stop();
+        return;
+    }
+    loader_stop();
+    hl_set_retained_mode(0);
+    hl_clear_tiles();
+    hl_clear_textures();
+    if (g_instances) { free(g_instances); g_instances = NULL; g_instance_count = 0; g_instance_cap = 0; }
+    if (g_labels) { free(g_labels); g_labels = NULL; g_label_count = 0; g_label_cap = 0; }
+    batch_free();
+    draw_list_free();
+    g_corner_size = -1.0f;
+    backbuffer_free();
+    spatial_free(&g_tile_index);
+    spatial_free(&g_instance_index);
+    spatial_free(&g_label_index);
+    pool_stop();
+    path_free();
+    vis_free();
+    free(g_visible);
+    g_visible = NULL;
+    g_visible_cap = 0;
+    free(g_visible_chunks);
+    g_visible_chunks = NULL;
+    g_visible_chunks_cap = 0;
+    if (g_font_texture) { SDL_DestroyTexture(g_font_texture); g_font_texture = NULL; }
+    if (g_renderer) { SDL_DestroyRenderer(g_renderer); g_renderer = NULL; }
+    if (g_window)   { SDL_DestroyWindow(g_window); g_window = NULL; }
+    if (g_offscreen) { SDL_FreeSurface(g_offscreen); g_offscreen = NULL; }
+    g_output_w = g_output_h = 0;
+    IMG_Quit();
+    SDL_Quit();
+}
+
+HEXLIB_API void hl_set_grid(int rows, int cols, float hex_size, int flat_top) {
+    g_grid.rows = rows;
+    g_grid.cols = cols;
+    g_grid.size = hex_size;
+    g_grid.flat_top = flat_top ? 1 : 0;
+    g_orient = flat_top ? &g_orient_flat : &g_orient_pointy;
+
+    // Center grid roughly in window
+    int w=0,h=0;
+    hl_get_output_size(&w, &h);
+    float grid_w = (3.0f/2.0f * (cols-1) * hex_size) + 2.0f*hex_size;
+    float grid_h = (HL_SQRT3 * hex_size * (rows + 0.5f)) + hex_size;
+    if (!flat_top) {
+        grid_w = (HL_SQRT3 * hex_size * (cols + 0.5f)) + hex_size;
+        grid_h = (3.0f/2.0f * (rows-1) * hex_size) + 2.0f*hex_size;
+    }
+    float origin_x = (w - grid_w) * 0.5f + hex_size;
+    float origin_y = (h - grid_h) * 0.5f + hex_size;
+    if (grid_w > w) origin_x = w * 0.5f;
+    if (grid_h > h) origin_y = h * 0.5f;
+    g_grid.origin_x = origin_x;
+    g_grid.origin_y = origin_y;
+    scene_damage_all();
+}
+
+HEXLIB_API void hl_set_camera(float offset_x, float offset_y, float zoom) {
+    if (zoom < 0.05f) zoom = 0.05f;
+    if (offset_x == g_camera_offset_x && offset_y == g_camera_offset_y && zoom == g_camera_zoom) return;
+    g_camera_offset_x = offset_x;
+    g_camera_offset_y = offset_y;
+    g_camera_zoom = zoom;
+    scene_damage_all();
+}
+
+// --- Tile store ---
+// g_tiles is a persistent store keyed by (q, r). g_tile_lookup maps a
+// coordinate to its slot so hl_update_tiles/hl_remove_tiles only touch the
+// tiles they name; every change is recorded as a per-tile dirty field mask.
+typedef struct {
+    int32_t q, r;
+    int     index;   // slot in g_tiles, -1 = empty
+} HL_TileKey;
+
+static HL_TileKey* g_tile_lookup = NULL;
+static int         g_tile_lookup_cap = 0;     // power of two
+static int         g_tile_lookup_used = 0;
+static int         g_tile_cap = 0;
+static int         g_tile_meta_cap = 0;       // capacity of the g_tile_dirty* arrays
+static HL_TileInstance* g_tile_back = NULL;   // hl_map_tiles buffer, swapped with g_tiles on commit
+static int         g_tile_back_cap = 0;
+static uint8_t*    g_tile_dirty = NULL;       // per-tile HL_TILE_* mask changed since the last hl_step
+static int*        g_tile_dirty_list = NULL;  // tiles with a non-zero g_tile_dirty entry
+static int*        g_tile_dirty_pos = NULL;   // per tile: its entry in g_tile_dirty_list while dirty
+static int         g_tile_dirty_count = 0;
+static int         g_tile_dirty_all = 0;      // set/remove: treat every tile as changed
+
+static int tile_lookup_find(int32_t q, int32_t r) {
+    if (!g_tile_lookup) return -1;
+    uint32_t mask = (uint32_t)g_tile_lookup_cap - 1;
+    for (uint32_t i = axial_hash(q, r) & mask;; i = (i + 1) & mask) {
+        const HL_TileKey* k = &g_tile_lookup[i];
+        if (k->index < 0) return -1;
+        if (k->q == q && k->r == r) return k->index;
+    }
+}
+
+// Insert or overwrite the slot for (q, r)
+static void tile_lookup_put(HL_TileKey* table, int cap, int32_t q, int32_t r, int index, int* used) {
+    uint32_t mask = (uint32_t)cap - 1;
+    uint32_t i = axial_hash(q, r) & mask;
+    while (table[i].index >= 0 && (table[i].q != q || table[i].r != r)) i = (i + 1) & mask;
+    if (table[i].index < 0) (*used)++;
+    table[i].q = q;
+    table[i].r = r;
+    table[i].index = index;
+}
+
+static int tile_lookup_reserve(int entries) {
+    if (entries * 2 <= g_tile_lookup_cap) return 1;
+    int cap = g_tile_lookup_cap ? g_tile_lookup_cap : 64;
+    while (cap < entries * 2) cap *= 2;
+    HL_TileKey* table = (HL_TileKey*)heap_malloc(sizeof(HL_TileKey) * cap);
+    if (!table) return 0;
+    for (int i = 0; i < cap; ++i) table[i].index = -1;
+    int used = 0;
+    for (int i = 0; i < g_tile_lookup_cap; ++i) {
+        const HL_TileKey* k = &g_tile_lookup[i];
+        if (k->index >= 0) tile_lookup_put(table, cap, k->q, k->r, k->index, &used);
+    }
+    free(g_tile_lookup);
+    g_tile_lookup = table;
+    g_tile_lookup_cap = cap;
+    g_tile_lookup_used = used;
+    return 1;
+}
+
+// Linear-probing delete with backward shift (no tombstones)
+static void tile_lookup_remove(HL_TileKey* table, int cap, int32_t q, int32_t r, int* used) {
+    if (!table) return;
+    uint32_t mask = (uint32_t)cap - 1;
+    uint32_t i = axial_hash(q, r) & mask;
+    while (table[i].index >= 0 && (table[i].q != q || table[i].r != r)) i = (i + 1) & mask;
+    if (table[i].index < 0) return;
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & mask; table[j].index >= 0; j = (j + 1) & mask) {
+        uint32_t home = axial_hash(table[j].q, table[j].r) & mask;
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        int stays = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!stays) {
+            table[hole] = table[j];
+            hole = j;
+        }
+    }
+    table[hole].index = -1;
+    (*used)--;
+}
+
+static void tile_lookup_rebuild(void) {
+    for (int i = 0; i < g_tile_lookup_cap; ++i) g_tile_lookup[i].index = -1;
+    g_tile_lookup_used = 0;
+    if (!tile_lookup_reserve(g_tile_count)) return;
+    for (int i = 0; i < g_tile_count; ++i) {
+        tile_lookup_put(g_tile_lookup, g_tile_lookup_cap, g_tiles[i].q, g_tiles[i].r, i, &g_tile_lookup_used);
+    }
+}
+
+static void tile_track_extent(const HL_TileInstance* t) {
+    if (t->terrain_scale > g_tile_max_scale) g_tile_max_scale = t->terrain_scale;
+    if (t->unit_scale > g_tile_max_scale) g_tile_max_scale = t->unit_scale;
+    float off = fmaxf(fabsf(t->offset_x), fabsf(t->offset_y));
+    if (off > g_tile_max_offset) g_tile_max_offset = off;
+}
+
+static void tile_mark_dirty(int index, uint32_t fields) {
+    if (g_tile_dirty_all || fields == 0) return;
+    if (g_tile_dirty[index] == 0) {
+        g_tile_dirty_pos[index] = g_tile_dirty_count;
+        g_tile_dirty_list[g_tile_dirty_count++] = index;
+        scene_damage_chunk(chunk_coord(g_tiles[index].q), chunk_coord(g_tiles[index].r));
+    }
+    g_tile_dirty[index] |= (uint8_t)fields;
+}
+
+static void tile_mark_all_dirty(void) {
+    g_tile_dirty_all = 1;
+    scene_damage_all();
+    for (int k = 0; k < g_tile_dirty_count; ++k) g_tile_dirty[g_tile_dirty_list[k]] = 0;
+    g_tile_dirty_count = 0;
+    g_tile_index.dirty = 1;
+}
+
+// Forget the pending changes of a tile that is being removed
+static void tile_dirty_drop(int index) {
+    if (g_tile_dirty[index] == 0) return;
+    int pos = g_tile_dirty_pos[index];
+    int tail = g_tile_dirty_list[--g_tile_dirty_count];
+    g_tile_dirty_list[pos] = tail;
+    g_tile_dirty_pos[tail] = pos;
+    g_tile_dirty[index] = 0;
+}
+
+// Carry the pending changes of tile `from` over to slot `to` (which is clean)
+static void tile_dirty_move(int from, int to) {
+    if (g_tile_dirty[from] == 0) return;
+    int pos = g_tile_dirty_pos[from];
+    g_tile_dirty_list[pos] = to;
+    g_tile_dirty_pos[to] = pos;
+    g_tile_dirty[to] = g_tile_dirty[from];
+    g_tile_dirty[from] = 0;
+}
+
+static void tile_dirty_reset(void) {
+    for (int k = 0; k < g_tile_dirty_count; ++k) g_tile_dirty[g_tile_dirty_list[k]] = 0;
+    g_tile_dirty_count = 0;
+    g_tile_dirty_all = 0;
+}
+
+// Grow the per-tile dirty arrays to cover `cap` tiles
+static int tile_meta_reserve(int cap) {
+    if (cap <= g_tile_meta_cap) return 1;
+    uint8_t* dirty = (uint8_t*)heap_realloc(g_tile_dirty, (size_t)cap);
+    if (!dirty) return 0;
+    memset(dirty + g_tile_meta_cap, 0, (size_t)(cap - g_tile_meta_cap));
+    g_tile_dirty = dirty;
+    int* list = (int*)heap_realloc(g_tile_dirty_list, sizeof(int) * cap);
+    if (!list) return 0;
+    g_tile_dirty_list = list;
+    int* pos = (int*)heap_realloc(g_tile_dirty_pos, sizeof(int) * cap);
+    if (!pos) return 0;
+    g_tile_dirty_pos = pos;
+    g_tile_meta_cap = cap;
+    return 1;
+}
+
+// Grow the store (and its dirty bookkeeping) to hold at least `count` tiles
+static int tile_reserve(int count) {
+    if (count > g_tile_cap) {
+        int cap = g_tile_cap ? g_tile_cap : 256;
+        while (cap < count) cap *= 2;
+        HL_TileInstance* tiles = (HL_TileInstance*)heap_realloc(g_tiles, sizeof(HL_TileInstance) * cap);
+        if (!tiles) return 0;
+        g_tiles = tiles;
+        g_tile_cap = cap;
+    }
+    return tile_meta_reserve(g_tile_cap);
+}
+
+// Which HL_TILE_* field groups differ between two tiles at the same coordinate
+static uint32_t tile_diff(const HL_TileInstance* a, const HL_TileInstance* b) {
+    uint32_t fields = 0;
+    if (a->terrain_tex != b->terrain_tex || a->terrain_scale != b->terrain_scale) fields |= HL_TILE_TERRAIN;
+    if (a->unit_tex != b->unit_tex || a->unit_scale != b->unit_scale) fields |= HL_TILE_UNIT;
+    if (memcmp(&a->overlay, &b->overlay, sizeof(HL_Color)) != 0) fields |= HL_TILE_OVERLAY;
+    if (a->offset_x != b->offset_x || a->offset_y != b->offset_y) fields |= HL_TILE_OFFSET;
+    return fields;
+}
+
+static void tile_store_free(void) {
+    free(g_tiles); g_tiles = NULL;
+    free(g_tile_back); g_tile_back = NULL;
+    free(g_tile_lookup); g_tile_lookup = NULL;
+    free(g_tile_dirty); g_tile_dirty = NULL;
+    free(g_tile_dirty_list); g_tile_dirty_list = NULL;
+    free(g_tile_dirty_pos); g_tile_dirty_pos = NULL;
+    g_tile_count = 0;
+    g_tile_cap = 0;
+    g_tile_meta_cap = 0;
+    g_tile_back_cap = 0;
+    g_tile_lookup_cap = 0;
+    g_tile_lookup_used = 0;
+    g_tile_dirty_count = 0;
+    g_tile_dirty_all = 0;
+    g_tile_index.dirty = 1;
+}
+
+// Empty the store but keep its buffers for the next upload
+static void tile_store_clear(void) {
+    if (g_tile_count == 0) return;
+    for (int i = 0; i < g_tile_lookup_cap; ++i) g_tile_lookup[i].index = -1;
+    g_tile_lookup_used = 0;
+    g_tile_count = 0;
+    tile_mark_all_dirty();
+}
+
+// Instances and labels are grow-only too: replacing or dropping them keeps
+// the capacity, so uploading a similar set every frame stays off the heap
+static int instance_reserve(int count) {
+    if (count <= g_instance_cap) return 1;
+    int cap = g_instance_cap ? g_instance_cap : 256;
+    while (cap < count) cap *= 2;
+    HL_HexInstance* instances = (HL_HexInstance*)heap_realloc(g_instances, sizeof(HL_HexInstance) * cap);
+    if (!instances) return 0;
+    g_instances = instances;
+    g_instance_cap = cap;
+    return 1;
+}
+
+static void instances_clear(void) {
+    if (g_instance_count == 0) return;
+    g_instance_count = 0;
+    g_instance_index.dirty = 1;
+}
+
+static int label_reserve(int count) {
+    if (count <= g_label_cap) return 1;
+    int cap = g_label_cap ? g_label_cap : 256;
+    while (cap < count) cap *= 2;
+    HL_DebugLabel* labels = (HL_DebugLabel*)heap_realloc(g_labels, sizeof(HL_DebugLabel) * cap);
+    if (!labels) return 0;
+    g_labels = labels;
+    g_label_cap = cap;
+    return 1;
+}
+
+static void labels_clear(void) {
+    if (g_label_count == 0) return;
+    g_label_count = 0;
+    g_label_index.dirty = 1;
+}
+
+// --- Tile columns ---
+// Render-side copy of the tile store as structure-of-arrays columns in
+// spatial-index order: column j holds tile g_tile_index.order[j], so each
+// chunk is a contiguous run of columns. The projection kernel streams q, r
+// and the offsets through SIMD registers and the draw passes read only the
+// columns they use. g_tiles stays the upload format handed to the embedder.
+typedef struct {
+    int32_t*  q;
+    int32_t*  r;
+    float*    offset_x;
+    float*    offset_y;
+    int32_t*  terrain;        // terrain_tex
+    int32_t*  unit;           // unit_tex
+    float*    terrain_scale;
+    float*    unit_scale;
+    HL_Color* overlay;
+    int*      column_of;      // tile index -> column
+    void*     block;          // single allocation backing every column
+    int       cap;
+    int       count;
+} HL_TileColumns;
+
+static HL_TileColumns g_cols = {0};
+
+static int tile_columns_reserve(int count) {
+    if (count <= g_cols.cap) return 1;
+    int cap = g_cols.cap ? g_cols.cap : 256;
+    while (cap < count) cap *= 2;
+    // Ten 4-byte columns, carried over so in-place index edits keep them
+    uint8_t* block = (uint8_t*)heap_malloc((size_t)cap * 4 * 10);
+    if (!block) return 0;
+    for (int k = 0; g_cols.block && k < 10; ++k) {
+        memcpy(block + (size_t)cap * 4 * k, (uint8_t*)g_cols.block + (size_t)g_cols.cap * 4 * k, (size_t)g_cols.cap * 4);
+    }
+    free(g_cols.block);
+    g_cols.block = block;
+    g_cols.q = (int32_t*)block;               block += (size_t)cap * 4;
+    g_cols.r = (int32_t*)block;               block += (size_t)cap * 4;
+    g_cols.offset_x = (float*)block;          block += (size_t)cap * 4;
+    g_cols.offset_y = (float*)block;          block += (size_t)cap * 4;
+    g_cols.terrain = (int32_t*)block;         block += (size_t)cap * 4;
+    g_cols.unit = (int32_t*)block;            block += (size_t)cap * 4;
+    g_cols.terrain_scale = (float*)block;     block += (size_t)cap * 4;
+    g_cols.unit_scale = (float*)block;        block += (size_t)cap * 4;
+    g_cols.overlay = (HL_Color*)block;        block += (size_t)cap * 4;
+    g_cols.column_of = (int*)block;
+    g_cols.cap = cap;
+    return 1;
+}
+
+static void tile_columns_store(int column, int index) {
+    const HL_TileInstance* t = &g_tiles[index];
+    g_cols.q[column] = t->q;
+    g_cols.r[column] = t->r;
+    g_cols.offset_x[column] = t->offset_x;
+    g_cols.offset_y[column] = t->offset_y;
+    g_cols.terrain[column] = t->terrain_tex;
+    g_cols.unit[column] = t->unit_tex;
+    g_cols.terrain_scale[column] = t->terrain_scale;
+    g_cols.unit_scale[column] = t->unit_scale;
+    g_cols.overlay[column] = t->overlay;
+    g_cols.column_of[index] = column;
+}
+
+// Re-lay the columns after the tile index was rebuilt
+static void tile_columns_build(void) {
+    g_cols.count = 0;
+    if (!tile_columns_reserve(g_tile_index.item_count)) return;
+    for (int j = 0; j < g_tile_index.item_count; ++j) tile_columns_store(j, g_tile_index.order[j]);
+    g_cols.count = g_tile_index.item_count;
+}
+
+// Move column `from` (and its order entry) to column `to`
+static void tile_columns_move(int from, int to) {
+    g_cols.q[to] = g_cols.q[from];
+    g_cols.r[to] = g_cols.r[from];
+    g_cols.offset_x[to] = g_cols.offset_x[from];
+    g_cols.offset_y[to] = g_cols.offset_y[from];
+    g_cols.terrain[to] = g_cols.terrain[from];
+    g_cols.unit[to] = g_cols.unit[from];
+    g_cols.terrain_scale[to] = g_cols.terrain_scale[from];
+    g_cols.unit_scale[to] = g_cols.unit_scale[from];
+    g_cols.overlay[to] = g_cols.overlay[from];
+    int index = g_tile_index.order[from];
+    g_tile_index.order[to] = index;
+    g_cols.column_of[index] = to;
+}
+
+// In-place index edits. Adding or removing a tile patches its chunk's run of
+// `order` and the columns instead of rebuilding both. A run that has to grow
+// is moved to the end, and removals shrink a run from its end. Either can
+// leave gaps, which frame_build repacks once they outnumber the tiles. These
+// do nothing while a full rebuild is pending.
+static int tile_index_patchable(void) {
+    if (g_tile_index.dirty) return 0;
+    if (g_cols.count == g_tile_index.item_count) return 1;
+    g_tile_index.dirty = 1;
+    return 0;
+}
+
+// Add tile `index`, just appended to the store
+static void tile_index_add(int index) {
+    if (!tile_index_patchable()) return;
+    HL_SpatialIndex* idx = &g_tile_index;
+    int32_t cq = chunk_coord(g_tiles[index].q), cr = chunk_coord(g_tiles[index].r);
+    HL_ChunkBucket* b = spatial_find(idx, cq, cr);
+    int end = idx->item_count;
+    int need = end + 1 + (b && b->start + b->count != end ? b->count : 0);
+    int orders = idx->order_cap ? idx->order_cap : 256;
+    while (orders < need) orders *= 2;
+    if (orders > idx->order_cap) {
+        int* order = (int*)heap_realloc(idx->order, sizeof(int) * orders);
+        if (!order) {
+            idx->dirty = 1;
+            return;
+        }
+        idx->order = order;
+        idx->order_cap = orders;
+    }
+    if (!tile_columns_reserve(need)) {
+        idx->dirty = 1;
+        return;
+    }
+    if (!b) {
+        if ((idx->bucket_used + 1) * 2 > idx->bucket_cap && !spatial_grow(idx)) {
+            idx->dirty = 1;
+            return;
+        }
+        uint32_t mask = (uint32_t)idx->bucket_cap - 1;
+        uint32_t j = axial_hash(cq, cr) & mask;
+        while (idx->buckets[j].count != 0) j = (j + 1) & mask;
+        b = &idx->buckets[j];
+        b->cq = cq;
+        b->cr = cr;
+        b->start = end;
+        spatial_extend(idx, cq, cr);
+        idx->bucket_used++;
+    } else if (b->start + b->count != end) {
+        for (int k = 0; k < b->count; ++k) tile_columns_move(b->start + k, end + k);
+        b->start = end;
+        end += b->count;
+    }
+    idx->order[end] = index;
+    tile_columns_store(end, index);
+    b->count++;
+    idx->item_count = g_cols.count = end + 1;
+}
+
+// Take tile `index` out of its run. Returns the bucket slot it was in, or -1
+// if the index is waiting for a rebuild. A bucket left empty is still in
+// place; the caller drops it with spatial_remove_bucket.
+static int tile_index_remove(int index) {
+    if (!tile_index_patchable()) return -1;
+    HL_SpatialIndex* idx = &g_tile_index;
+    HL_ChunkBucket* b = spatial_find(idx, chunk_coord(g_tiles[index].q), chunk_coord(g_tiles[index].r));
+    if (!b) {
+        idx->dirty = 1;
+        return -1;
+    }
+    int last = b->start + b->count - 1;
+    if (g_cols.column_of[index] != last) tile_columns_move(last, g_cols.column_of[index]);
+    b->count--;
+    if (last == idx->item_count - 1) idx->item_count = g_cols.count = last;
+    return (int)(b - idx->buckets);
+}
+
+// Tile `from` now lives in store slot `to`; its column stays where it is
+static void tile_index_renumber(int from, int to) {
+    if (!tile_index_patchable()) return;
+    int column = g_cols.column_of[from];
+    g_tile_index.order[column] = to;
+    g_cols.column_of[to] = column;
+}
+
+// Copy the tiles changed since the last frame into their columns
+static void tile_columns_sync(void) {
+    if (g_tile_dirty_all || g_cols.count != g_tile_index.item_count) {
+        tile_columns_build();
+        return;
+    }
+    for (int k = 0; k < g_tile_dirty_count; ++k) {
+        int i = g_tile_dirty_list[k];
+        tile_columns_store(g_cols.column_of[i], i);
+    }
+}
+
+static void tile_columns_free(void) {
+    free(g_cols.block);
+    memset(&g_cols, 0, sizeof(g_cols));
+}
+
+// --- Map files ---
+// A map file is a header, a chunk index sorted by (cq, cr) and the tile
+// records grouped by chunk, all little-endian:
+//
+//   HL_MapHeader | HL_MapChunk[chunk_count] | HL_MapTile[tile_count]
+//
+// hl_load_map maps the file read-only and only reads the header. Each frame
+// the chunks that are about to scroll into view are copied into the tile
+// store, so opening costs the same for any map size and the OS pages in only
+// the parts of the file that were looked at. Per-tile offsets are animation
+// state and are not stored. Chunks the embedder never edited are copies of
+// the file, so once HL_MAP_RESIDENT_CHUNKS of them are in the store the ones
+// seen longest ago are dropped again and re-read if they come back into view.
+#define HL_MAP_MAGIC      "HEXMAP\r\n"
+#define HL_MAP_VERSION    1
+#define HL_MAP_BYTE_ORDER 0x01020304u
+#define HL_MAP_RESIDENT_CHUNKS 4096   // unedited chunks kept before eviction (256k tiles)
+#define HL_MAP_EVICTS_PER_FRAME 256
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;    // HL_MAP_BYTE_ORDER as written by the saving host
+    uint32_t header_size;   // sizeof(HL_MapHeader)
+    uint32_t chunk_size;    // HL_CHUNK_SIZE
+    uint32_t chunk_count;
+    uint32_t tile_count;
+    uint64_t chunks_offset;
+    uint64_t tiles_offset;
+} HL_MapHeader;
+
+typedef struct {
+    int32_t  cq, cr;
+    uint32_t first;         // index of the chunk's first record
+    uint32_t count;
+} HL_MapChunk;
+
+typedef struct {
+    uint8_t  cell;          // (q - cq * HL_CHUNK_SIZE) + (r - cr * HL_CHUNK_SIZE) * HL_CHUNK_SIZE
+    int8_t   terrain_tex;
+    int8_t   unit_tex;
+    uint8_t  reserved;
+    HL_Color overlay;
+    float    terrain_scale;
+    float    unit_scale;
+} HL_MapTile;
+
+typedef struct {
+    const uint8_t*     data;
+    size_t             size;
+    const HL_MapChunk* chunks;
+    const HL_MapTile*  tiles;
+    uint32_t           chunk_count;
+    uint8_t*           resident;  // per chunk: HL_CHUNK_* state
+    uint32_t*          seen;      // per chunk: map_stream pass that last had it in view
+    uint32_t           pass;
+    uint32_t           unedited;  // chunks in HL_CHUNK_LOADED
+#ifdef _WIN32
+    HANDLE             file;
+    HANDLE             mapping;
+#endif
+} HL_Map;
+
+enum { HL_CHUNK_ABSENT, HL_CHUNK_LOADED, HL_CHUNK_EDITED };
+
+static HL_Map g_map = {0};
+
+static void map_unmap(HL_Map* map) {
+#ifdef _WIN32
+    if (map->data) UnmapViewOfFile(map->data);
+    if (map->mapping) CloseHandle(map->mapping);
+    if (map->file && map->file != INVALID_HANDLE_VALUE) CloseHandle(map->file);
+#else
+    if (map->data) munmap((void*)map->data, map->size);
+#endif
+    free(map->resident);
+    free(map->seen);
+    memset(map, 0, sizeof(*map));
+}
+
+// Map `path` read-only and check that its header and index are consistent
+static int map_open(HL_Map* map, const char* path) {
+    memset(map, 0, sizeof(*map));
+#ifdef _WIN32
+    map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (map->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(map->file, &size)) {
+        SDL_Log("Map '%s' could not be opened", path);
+        map_unmap(map);
+        return 0;
+    }
+    map->size = (size_t)size.QuadPart;
+    if (map->size >= sizeof(HL_MapHeader)) {
+        map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (map->mapping) map->data = (const uint8_t*)MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        SDL_Log("Map '%s' could not be opened", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    map->size = (size_t)st.st_size;
+    if (map->size >= sizeof(HL_MapHeader)) {
+        void* data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) map->data = (const uint8_t*)data;
+    }
+    close(fd);
+#endif
+    if (!map->data) {
+        SDL_Log("Map '%s' is too small or could not be mapped", path);
+        map_unmap(map);
+        return 0;
+    }
+
+    const HL_MapHeader* h = (const HL_MapHeader*)map->data;
+    uint64_t chunks_end = h->chunks_offset + (uint64_t)h->chunk_count * sizeof(HL_MapChunk);
+    uint64_t tiles_end = h->tiles_offset + (uint64_t)h->tile_count * sizeof(HL_MapTile);
+    if (memcmp(h->magic, HL_MAP_MAGIC, 8) != 0 || h->version != HL_MAP_VERSION ||
+        h->byte_order != HL_MAP_BYTE_ORDER || h->header_size != sizeof(HL_MapHeader) ||
+        h->chunk_size != HL_CHUNK_SIZE || h->chunks_offset % 4 != 0 || h->tiles_offset % 4 != 0 ||
+        h->chunks_offset < sizeof(HL_MapHeader) || chunks_end > map->size ||
+        h->tiles_offset < chunks_end || tiles_end > map->size) {
+        SDL_Log("Map '%s' has an unsupported or damaged header", path);
+        map_unmap(map);
+        return 0;
+    }
+    map->chunks = (const HL_MapChunk*)(map->data + h->chunks_offset);
+    map->tiles = (const HL_MapTile*)(map->data + h->tiles_offset);
+    map->chunk_count = h->chunk_count;
+    for (uint32_t i = 0; i < map->chunk_count; ++i) {
+        const HL_MapChunk* c = &map->chunks[i];
+        int sorted = i == 0 || c[-1].cq < c->cq || (c[-1].cq == c->cq && c[-1].cr < c->cr);
+        if (!sorted || c->count > HL_CHUNK_SIZE * HL_CHUNK_SIZE || c->first > h->tile_count ||
+            c->count > h->tile_count - c->first) {
+            SDL_Log("Map '%s' has a damaged chunk index", path);
+            map_unmap(map);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Detach the open map, if any. Tiles already copied out of it stay.
+static void map_close(void) {
+    if (g_map.data) map_unmap(&g_map);
+}
+
+// First chunk at or after (cq, cr)
+static uint32_t map_lower_bound(int32_t cq, int32_t cr) {
+    uint32_t lo = 0, hi = g_map.chunk_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const HL_MapChunk* c = &g_map.chunks[mid];
+        if (c->cq < cq || (c->cq == cq && c->cr < cr)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Copy chunk `k` into the tile store and the index around it. Coordinates
+// the store already holds (tiles the embedder added or patched) are kept as
+// they are.
+static void map_load_chunk(uint32_t k) {
+    if (g_map.resident[k] != HL_CHUNK_ABSENT) return;
+    const HL_MapChunk* c = &g_map.chunks[k];
+    if (!tile_reserve(g_tile_count + (int)c->count) ||
+        !tile_lookup_reserve(g_tile_lookup_used + (int)c->count)) return;
+    g_map.resident[k] = HL_CHUNK_LOADED;
+    g_map.unedited++;
+    for (uint32_t j = 0; j < c->count; ++j) {
+        const HL_MapTile* m = &g_map.tiles[c->first + j];
+        int32_t q = c->cq * HL_CHUNK_SIZE + m->cell % HL_CHUNK_SIZE;
+        int32_t r = c->cr * HL_CHUNK_SIZE + (m->cell / HL_CHUNK_SIZE) % HL_CHUNK_SIZE;
+        if (tile_lookup_find(q, r) >= 0) continue;
+        int i = g_tile_count++;
+        HL_TileInstance* t = &g_tiles[i];
+        t->q = q;
+        t->r = r;
+        t->terrain_tex = m->terrain_tex >= 0 && m->terrain_tex < HL_MAX_TEXTURE_SLOTS ? m->terrain_tex : -1;
+        t->unit_tex = m->unit_tex >= 0 && m->unit_tex < HL_MAX_TEXTURE_SLOTS ? m->unit_tex : -1;
+        t->terrain_scale = m->terrain_scale;
+        t->unit_scale = m->unit_scale;
+        t->overlay = m->overlay;
+        t->offset_x = 0.0f;
+        t->offset_y = 0.0f;
+        g_tile_dirty[i] = 0;
+        tile_lookup_put(g_tile_lookup, g_tile_lookup_cap, q, r, i, &g_tile_lookup_used);
+        tile_index_add(i);
+        tile_track_extent(t);
+        tile_mark_dirty(i, HL_TILE_ALL);
+    }
+}
+
+// Make sure the chunk holding (q, r) is in the tile store before it is
+// edited, and keep it there from now on
+static void map_touch(int32_t q, int32_t r) {
+    if (!g_map.data) return;
+    int32_t cq = chunk_coord(q), cr = chunk_coord(r);
+    uint32_t k = map_lower_bound(cq, cr);
+    if (k >= g_map.chunk_count || g_map.chunks[k].cq != cq || g_map.chunks[k].cr != cr) return;
+    map_load_chunk(k);
+    if (g_map.resident[k] == HL_CHUNK_LOADED) {
+        g_map.resident[k] = HL_CHUNK_EDITED;
+        g_map.unedited--;
+    }
+}
+
+// Copy in every chunk that can overlap the screen, `margin` world units around it
+static void map_stream(int win_w, int win_h, float margin) {
+    if (!g_map.data || g_map.chunk_count == 0 || g_grid.size <= 0.0f) return;
+    g_map.pass++;
+    HL_ViewRange view;
+    view_range(&view, win_w, win_h, margin);
+    int32_t cq_lo = chunk_coord(view.q_lo), cq_hi = chunk_coord(view.q_hi);
+    if (cq_lo < g_map.chunks[0].cq) cq_lo = g_map.chunks[0].cq;
+    if (cq_hi > g_map.chunks[g_map.chunk_count - 1].cq) cq_hi = g_map.chunks[g_map.chunk_count - 1].cq;
+    for (int32_t cq = cq_lo; cq <= cq_hi; ++cq) {
+        int32_t cr_lo, cr_hi;
+        view_chunk_rows(&view, cq, &cr_lo, &cr_hi);
+        for (uint32_t k = map_lower_bound(cq, cr_lo);
+             k < g_map.chunk_count && g_map.chunks[k].cq == cq && g_map.chunks[k].cr <= cr_hi; ++k) {
+            map_load_chunk(k);
+            g_map.seen[k] = g_map.pass;
+        }
+    }
+}
+
+static int map_key_compare(const void* a, const void* b) {
+    uint64_t ka = *(const uint64_t*)a, kb = *(const uint64_t*)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+HEXLIB_API void hl_set_instances(const HL_HexInstance* instances, int count) {
+    map_close();
+    tile_store_clear();
+    labels_clear();
+    instances_clear();
+    if (count <= 0 || !instances || !instance_reserve(count)) return;
+    memcpy(g_instances, instances, sizeof(HL_HexInstance) * count);
+    HL_STAT_ADD(total_bytes_uploaded, sizeof(HL_HexInstance) * (uint64_t)count);
+    g_instance_count = count;
+    g_instance_index.dirty = 1;
+}
+
+// --- Projection kernel ---
+// Axial -> world -> screen folds into one affine map per axis, so projecting
+// a column range is a couple of multiply-adds per tile plus the cull compare.
+// The SIMD variants handle 4 (SSE2) or 8 (AVX2) tiles per step; the scalar
+// one covers the tails and everything else.
+typedef struct {
+    float kx, ky;          // screen position of axial (0, 0)
+    float qx, qy, rx, ry;  // screen delta per step in q and in r
+    float zoom;            // offsets are world pixels
+    float x0, y0, x1, y1;  // keep rectangle (screen plus cull margin)
+} HL_Projection;
+
+typedef int (*HL_ProjectFn)(const HL_Projection* p, int first, int count, int out);
+
+// Project columns [first, first + count) and append the ones inside the keep
+// rectangle to g_visible (as columns) and g_screen_pos from entry `out` on.
+// Returns the new entry count.
+static int project_columns_scalar(const HL_Projection* p, int first, int count, int out) {
+    for (int j = first; j < first + count; ++j) {
+        float x = p->kx + p->qx * (float)g_cols.q[j] + p->rx * (float)g_cols.r[j] + p->zoom * g_cols.offset_x[j];
+        float y = p->ky + p->qy * (float)g_cols.q[j] + p->ry * (float)g_cols.r[j] + p->zoom * g_cols.offset_y[j];
+        if (x < p->x0 || y < p->y0 || x > p->x1 || y > p->y1) continue;
+        g_visible[out] = j;
+        g_screen_pos[out].x = x;
+        g_screen_pos[out].y = y;
+        out++;
+    }
+    return out;
+}
+
+#if HL_SIMD_SSE2
+static int project_columns_sse2(const HL_Projection* p, int first, int count, int out) {
+    const __m128 kx = _mm_set1_ps(p->kx), ky = _mm_set1_ps(p->ky);
+    const __m128 qx = _mm_set1_ps(p->qx), qy = _mm_set1_ps(p->qy);
+    const __m128 rx = _mm_set1_ps(p->rx), ry = _mm_set1_ps(p->ry);
+    const __m128 zoom = _mm_set1_ps(p->zoom);
+    const __m128 x0 = _mm_set1_ps(p->x0), y0 = _mm_set1_ps(p->y0);
+    const __m128 x1 = _mm_set1_ps(p->x1), y1 = _mm_set1_ps(p->y1);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    int j = first, end = first + count;
+    for (; j + 4 <= end; j += 4) {
+        __m128 q = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&g_cols.q[j]));
+        __m128 r = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&g_cols.r[j]));
+        __m128 x = _mm_add_ps(_mm_add_ps(kx, _mm_mul_ps(qx, q)),
+                              _mm_add_ps(_mm_mul_ps(rx, r), _mm_mul_ps(zoom, _mm_loadu_ps(&g_cols.offset_x[j]))));
+        __m128 y = _mm_add_ps(_mm_add_ps(ky, _mm_mul_ps(qy, q)),
+                              _mm_add_ps(_mm_mul_ps(ry, r), _mm_mul_ps(zoom, _mm_loadu_ps(&g_cols.offset_y[j]))));
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, x0), _mm_cmple_ps(x, x1)),
+                                   _mm_and_ps(_mm_cmpge_ps(y, y0), _mm_cmple_ps(y, y1)));
+        int mask = _mm_movemask_ps(inside);
+        if (mask == 0) continue;
+        if (mask == 0xF) {
+            // Whole group visible (the common case inside the screen)
+            _mm_storeu_ps(&g_screen_pos[out].x, _mm_unpacklo_ps(x, y));
+            _mm_storeu_ps(&g_screen_pos[out + 2].x, _mm_unpackhi_ps(x, y));
+            _mm_storeu_si128((__m128i*)&g_visible[out], _mm_add_epi32(_mm_set1_epi32(j), lanes));
+            out += 4;
+            continue;
+        }
+        float xs[4], ys[4];
+        _mm_storeu_ps(xs, x);
+        _mm_storeu_ps(ys, y);
+        for (int l = 0; l < 4; ++l) {
+            if (!(mask & (1 << l))) continue;
+            g_visible[out] = j + l;
+            g_screen_pos[out].x = xs[l];
+            g_screen_pos[out].y = ys[l];
+            out++;
+        }
+    }
+    return project_columns_scalar(p, j, end - j, out);
+}
+#endif
+
+#if HL_SIMD_AVX2
+HL_TARGET_AVX2
+static int project_columns_avx2(const HL_Projection* p, int first, int count, int out) {
+    const __m256 kx = _mm256_set1_ps(p->kx), ky = _mm256_set1_ps(p->ky);
+    const __m256 qx = _mm256_set1_ps(p->qx), qy = _mm256_set1_ps(p->qy);
+    const __m256 rx = _mm256_set1_ps(p->rx), ry = _mm256_set1_ps(p->ry);
+    const __m256 zoom = _mm256_set1_ps(p->zoom);
+    const __m256 x0 = _mm256_set1_ps(p->x0), y0 = _mm256_set1_ps(p->y0);
+    const __m256 x1 = _mm256_set1_ps(p->x1), y1 = _mm256_set1_ps(p->y1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int j = first, end = first + count;
+    for (; j + 8 <= end; j += 8) {
+        __m256 q = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)&g_cols.q[j]));
+        __m256 r = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)&g_cols.r[j]));
+        __m256 x = _mm256_add_ps(_mm256_add_ps(kx, _mm256_mul_ps(qx, q)),
+                                 _mm256_add_ps(_mm256_mul_ps(rx, r), _mm256_mul_ps(zoom, _mm256_loadu_ps(&g_cols.offset_x[j]))));
+        __m256 y = _mm256_add_ps(_mm256_add_ps(ky, _mm256_mul_ps(qy, q)),
+                                 _mm256_add_ps(_mm256_mul_ps(ry, r), _mm256_mul_ps(zoom, _mm256_loadu_ps(&g_cols.offset_y[j]))));
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x, x0, _CMP_GE_OQ), _mm256_cmp_ps(x, x1, _CMP_LE_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(y, y0, _CMP_GE_OQ), _mm256_cmp_ps(y, y1, _CMP_LE_OQ)));
+        int mask = _mm256_movemask_ps(inside);
+        if (mask == 0) continue;
+        if (mask == 0xFF) {
+            // unpack interleaves within 128-bit lanes; the permutes put the
+            // four (x, y) pairs of each half back in order
+            __m256 lo = _mm256_unpacklo_ps(x, y);
+            __m256 hi = _mm256_unpackhi_ps(x, y);
+            _mm256_storeu_ps(&g_screen_pos[out].x, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(&g_screen_pos[out + 4].x, _mm256_permute2f128_ps(lo, hi, 0x31));
+            _mm256_storeu_si256((__m256i*)&g_visible[out], _mm256_add_epi32(_mm256_set1_epi32(j), lanes));
+            out += 8;
+            continue;
+        }
+        float xs[8], ys[8];
+        _mm256_storeu_ps(xs, x);
+        _mm256_storeu_ps(ys, y);
+        for (int l = 0; l < 8; ++l) {
+            if (!(mask & (1 << l))) continue;
+            g_visible[out] = j + l;
+            g_screen_pos[out].x = xs[l];
+            g_screen_pos[out].y = ys[l];
+            out++;
+        }
+    }
+    return project_columns_scalar(p, j, end - j, out);
+}
+#endif
+
+static HL_ProjectFn g_project_columns = NULL;  // picked on first use from the CPU features
+
+static void projection_select_kernel(void) {
+    g_project_columns = project_columns_scalar;
+#if HL_SIMD_SSE2
+    g_project_columns = project_columns_sse2;
+#endif
+#if HL_SIMD_AVX2
+    if (SDL_HasAVX2()) g_project_columns = project_columns_avx2;
+#endif
+}
+
+static void projection_setup(HL_Projection* p, int win_w, int win_h, float cull) {
+    if (!g_project_columns) projection_select_kernel();
+    float zoom = g_camera_zoom < 0.05f ? 0.05f : g_camera_zoom;
+    float size = g_grid.size * zoom;
+    p->kx = (g_grid.origin_x + g_camera_offset_x - win_w * 0.5f) * zoom + win_w * 0.5f;
+    p->ky = (g_grid.origin_y + g_camera_offset_y - win_h * 0.5f) * zoom + win_h * 0.5f;
+    p->qx = g_orient->f0 * size;
+    p->rx = g_orient->f1 * size;
+    p->qy = g_orient->f2 * size;
+    p->ry = g_orient->f3 * size;
+    p->zoom = zoom;
+    p->x0 = -cull;
+    p->y0 = -cull;
+    p->x1 = win_w + cull;
+    p->y1 = win_h + cull;
+}
+
+// Narrow the keep rectangle to `clip` grown by the same cull margin
+static void projection_clip(HL_Projection* p, const SDL_Rect* clip, float cull) {
+    if (!clip) return;
+    p->x0 = (float)clip->x - cull;
+    p->y0 = (float)clip->y - cull;
+    p->x1 = (float)(clip->x + clip->w) + cull;
+    p->y1 = (float)(clip->y + clip->h) + cull;
+}
+
+// Screen bounds {x0, y0, x1, y1} of the hex centers of chunk (cq, cr), grown
+// by `pad` pixels
+static void chunk_screen_box(const HL_Projection* p, int32_t cq, int32_t cr, float pad, float box[4]) {
+    float qa = (float)(cq * HL_CHUNK_SIZE), qb = qa + (float)(HL_CHUNK_SIZE - 1);
+    float ra = (float)(cr * HL_CHUNK_SIZE), rb = ra + (float)(HL_CHUNK_SIZE - 1);
+    box[0] = p->kx + fminf(p->qx * qa, p->qx * qb) + fminf(p->rx * ra, p->rx * rb) - pad;
+    box[1] = p->ky + fminf(p->qy * qa, p->qy * qb) + fminf(p->ry * ra, p->ry * rb) - pad;
+    box[2] = p->kx + fmaxf(p->qx * qa, p->qx * qb) + fmaxf(p->rx * ra, p->rx * rb) + pad;
+    box[3] = p->ky + fmaxf(p->qy * qa, p->qy * qb) + fmaxf(p->ry * ra, p->ry * rb) + pad;
+}
+
+// Keep the first `chunks` entries of g_visible_chunks that can draw into
+// `clip` (tiles reaching at most `pad` pixels past their center); returns the
+// new count
+static int chunks_clip(int chunks, const HL_Projection* p, const SDL_Rect* clip, float pad) {
+    if (!clip) return chunks;
+    int n = 0;
+    for (int c = 0; c < chunks; ++c) {
+        const HL_ChunkBucket* b = &g_tile_index.buckets[g_visible_chunks[c]];
+        float box[4];
+        chunk_screen_box(p, b->cq, b->cr, pad, box);
+        if (box[2] < (float)clip->x || box[3] < (float)clip->y ||
+            box[0] > (float)(clip->x + clip->w) || box[1] > (float)(clip->y + clip->h)) continue;
+        g_visible_chunks[n++] = g_visible_chunks[c];
+    }
+    return n;
+}
+
+// Make room for `count` projected entries in g_visible and g_screen_pos
+static int projection_reserve(int count) {
+    if (!visible_reserve(count)) return 0;
+    if (g_screen_pos_cap < count) {
+        SDL_FPoint* pos = (SDL_FPoint*)heap_realloc(g_screen_pos, sizeof(SDL_FPoint) * count);
+        if (!pos) return 0;
+        g_screen_pos = pos;
+        g_screen_pos_cap = count;
+    }
+    return 1;
+}
+
+// Project every tile of the first `chunks` buckets in g_visible_chunks in one
+// sweep. Returns the number of on-screen tiles left in g_visible/g_screen_pos.
+static int project_chunks(const HL_Projection* p, int chunks) {
+    if (g_cols.count != g_tile_index.item_count || !projection_reserve(g_cols.count)) return 0;
+    int n = 0;
+    for (int c = 0; c < chunks; ++c) {
+        const HL_ChunkBucket* b = &g_tile_index.buckets[g_visible_chunks[c]];
+        n = g_project_columns(p, b->start, b->count, n);
+    }
+    return n;
+}
+
+// --- Hex math API ---
+// Array versions of the conversions above for embedders. Coordinates are
+// interleaved (q, r) int32 pairs and (x, y) float pairs in output pixels,
+// through the current grid, orientation and camera.
+static const int32_t g_hex_dirs[6][2] = { { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, 0 }, { -1, 1 }, { 0, 1 } };
+
+typedef struct {
+    float kx, ky;          // screen position of axial (0, 0)
+    float qx, qy, rx, ry;  // screen delta per step in q and in r
+    float sx, sy;          // world position of screen (0, 0), divided by size
+    float inv;             // 1 / (size * zoom)
+} HL_HexTransform;
+
+static int hex_transform(HL_HexTransform* t) {
+    if (g_grid.size <= 0.0f) return 0;
+    HL_Projection p;
+    projection_setup(&p, g_output_w, g_output_h, 0.0f);
+    t->kx = p.kx; t->ky = p.ky;
+    t->qx = p.qx; t->qy = p.qy; t->rx = p.rx; t->ry = p.ry;
+    float x = 0.0f, y = 0.0f;
+    screen_to_world_sized(&x, &y, g_output_w, g_output_h);
+    t->sx = (x - g_grid.origin_x) / g_grid.size;
+    t->sy = (y - g_grid.origin_y) / g_grid.size;
+    t->inv = 1.0f / (g_grid.size * p.zoom);
+    return 1;
+}
+
+static void hex_to_screen_scalar(const HL_HexTransform* t, const int32_t* qr, float* xy, int first, int count) {
+    for (int i = first; i < first + count; ++i) {
+        float q = (float)qr[2 * i], r = (float)qr[2 * i + 1];
+        xy[2 * i] = t->kx + t->qx * q + t->rx * r;
+        xy[2 * i + 1] = t->ky + t->qy * q + t->ry * r;
+    }
+}
+
+static void screen_to_hex_scalar(const HL_HexTransform* t, const float* xy, int32_t* qr, int first, int count) {
+    const HL_Orientation* o = g_orient;
+    for (int i = first; i < first + count; ++i) {
+        float x = t->sx + xy[2 * i] * t->inv, y = t->sy + xy[2 * i + 1] * t->inv;
+        float qf = o->b0 * x + o->b1 * y;
+        float rf = o->b2 * x + o->b3 * y;
+        cube_round(qf, -qf - rf, rf, &qr[2 * i], &qr[2 * i + 1]);
+    }
+}
+
+static void hex_distance_scalar(int32_t q, int32_t r, const int32_t* qr, int32_t* out, int first, int count) {
+    for (int i = first; i < first + count; ++i) out[i] = hex_distance(q, r, qr[2 * i], qr[2 * i + 1]);
+}
+
+#if HL_SIMD_SSE2
+// Two (q, r) pairs per vector: x, y = k + q * (qx, qy) + r * (rx, ry)
+static int hex_to_screen_sse2(const HL_HexTransform* t, const int32_t* qr, float* xy, int count) {
+    const __m128 k = _mm_setr_ps(t->kx, t->ky, t->kx, t->ky);
+    const __m128 dq = _mm_setr_ps(t->qx, t->qy, t->qx, t->qy);
+    const __m128 dr = _mm_setr_ps(t->rx, t->ry, t->rx, t->ry);
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128 v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&qr[2 * i]));
+        __m128 q = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 r = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+        _mm_storeu_ps(&xy[2 * i], _mm_add_ps(k, _mm_add_ps(_mm_mul_ps(q, dq), _mm_mul_ps(r, dr))));
+    }
+    return i;
+}
+
+static __m128 sse2_abs_ps(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+// Four points per step; cube_round with conversions rounding to even
+static int screen_to_hex_sse2(const HL_HexTransform* t, const float* xy, int32_t* qr, int count) {
+    const HL_Orientation* o = g_orient;
+    const __m128 sx = _mm_set1_ps(t->sx), sy = _mm_set1_ps(t->sy), inv = _mm_set1_ps(t->inv);
+    const __m128 b0 = _mm_set1_ps(o->b0), b1 = _mm_set1_ps(o->b1);
+    const __m128 b2 = _mm_set1_ps(o->b2), b3 = _mm_set1_ps(o->b3);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(&xy[2 * i]), b = _mm_loadu_ps(&xy[2 * i + 4]);
+        __m128 x = _mm_add_ps(sx, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), inv));
+        __m128 y = _mm_add_ps(sy, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), inv));
+        __m128 fq = _mm_add_ps(_mm_mul_ps(b0, x), _mm_mul_ps(b1, y));
+        __m128 fr = _mm_add_ps(_mm_mul_ps(b2, x), _mm_mul_ps(b3, y));
+        __m128 fs = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(fq, fr));
+        __m128i iq = _mm_cvtps_epi32(fq), ir = _mm_cvtps_epi32(fr), is = _mm_cvtps_epi32(fs);
+        __m128 dq = sse2_abs_ps(_mm_sub_ps(_mm_cvtepi32_ps(iq), fq));
+        __m128 dr = sse2_abs_ps(_mm_sub_ps(_mm_cvtepi32_ps(ir), fr));
+        __m128 ds = sse2_abs_ps(_mm_sub_ps(_mm_cvtepi32_ps(is), fs));
+        // q is rebuilt where its error is largest, r where neither q's nor s's is
+        __m128i fix_q = _mm_castps_si128(_mm_and_ps(_mm_cmpgt_ps(dq, ds), _mm_cmpgt_ps(dq, dr)));
+        __m128i fix_r = _mm_andnot_si128(fix_q, _mm_castps_si128(_mm_cmpge_ps(dr, ds)));
+        __m128i zero = _mm_setzero_si128();
+        __m128i q_alt = _mm_sub_epi32(_mm_sub_epi32(zero, is), ir);
+        __m128i r_alt = _mm_sub_epi32(_mm_sub_epi32(zero, iq), is);
+        iq = _mm_or_si128(_mm_and_si128(fix_q, q_alt), _mm_andnot_si128(fix_q, iq));
+        ir = _mm_or_si128(_mm_and_si128(fix_r, r_alt), _mm_andnot_si128(fix_r, ir));
+        _mm_storeu_si128((__m128i*)&qr[2 * i], _mm_unpacklo_epi32(iq, ir));
+        _mm_storeu_si128((__m128i*)&qr[2 * i + 4], _mm_unpackhi_epi32(iq, ir));
+    }
+    return i;
+}
+
+static __m128i sse2_abs_epi32(__m128i v) {
+    __m128i sign = _mm_srai_epi32(v, 31);
+    return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+// Four targets per step: (|dq| + |dr| + |dq + dr|) / 2
+static int hex_distance_sse2(int32_t q, int32_t r, const int32_t* qr, int32_t* out, int count) {
+    const __m128i origin = _mm_setr_epi32(q, r, q, r);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)&qr[2 * i]), origin);
+        __m128i b = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)&qr[2 * i + 4]), origin);
+        __m128i dq = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i dr = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i sum = _mm_add_epi32(_mm_add_epi32(sse2_abs_epi32(dq), sse2_abs_epi32(dr)),
+                                    sse2_abs_epi32(_mm_add_epi32(dq, dr)));
+        _mm_storeu_si128((__m128i*)&out[i], _mm_srli_epi32(sum, 1));
+    }
+    return i;
+}
+#endif
+
+HEXLIB_API void hl_axial_to_screen_batch(const int32_t* qr, float* xy, int count) {
+    HL_HexTransform t;
+    if (!qr || !xy || count <= 0 || !hex_transform(&t)) return;
+    int done = 0;
+#if HL_SIMD_SSE2
+    done = hex_to_screen_sse2(&t, qr, xy, count);
+#endif
+    hex_to_screen_scalar(&t, qr, xy, done, count - done);
+}
+
+HEXLIB_API void hl_screen_to_axial_batch(const float* xy, int32_t* qr, int count) {
+    HL_HexTransform t;
+    if (!xy || !qr || count <= 0 || !hex_transform(&t)) return;
+    int done = 0;
+#if HL_SIMD_SSE2
+    done = screen_to_hex_sse2(&t, xy, qr, count);
+#endif
+    screen_to_hex_scalar(&t, xy, qr, done, count - done);
+}
+
+HEXLIB_API void hl_hex_distance_batch(int32_t q, int32_t r, const int32_t* qr, int32_t* out, int count) {
+    if (!qr || !out || count <= 0) return;
+    int done = 0;
+#if HL_SIMD_SSE2
+    done = hex_distance_sse2(q, r, qr, out, count);
+#endif
+    hex_distance_scalar(q, r, qr, out, done, count - done);
+}
+
+// Append ring `radius` around (q, r) to out from entry n; returns the new n.
+// Only the first max_out entries are written, but all are counted.
+static int hex_ring_append(int32_t q, int32_t r, int radius, int32_t* out, int max_out, int n) {
+    if (radius == 0) {
+        if (n < max_out) { out[2 * n] = q; out[2 * n + 1] = r; }
+        return n + 1;
+    }
+    // Start `radius` steps in direction 4, then walk each side
+    int32_t cq = q + g_hex_dirs[4][0] * radius, cr = r + g_hex_dirs[4][1] * radius;
+    for (int side = 0; side < 6; ++side) {
+        for (int step = 0; step < radius; ++step) {
+            if (n < max_out) { out[2 * n] = cq; out[2 * n + 1] = cr; }
+            n++;
+            cq += g_hex_dirs[side][0];
+            cr += g_hex_dirs[side][1];
+        }
+    }
+    return n;
+}
+
+HEXLIB_API int hl_ring(int32_t q, int32_t r, int radius, int32_t* out, int max_out) {
+    if (radius < 0) return 0;
+    if (!out) max_out = 0;
+    return hex_ring_append(q, r, radius, out, max_out, 0);
+}
+
+HEXLIB_API int hl_spiral(int32_t q, int32_t r, int radius, int32_t* out, int max_out) {
+    if (radius < 0) return 0;
+    if (!out) max_out = 0;
+    int n = 0;
+    for (int k = 0; k <= radius; ++k) n = hex_ring_append(q, r, k, out, max_out, n);
+    return n;
+}
+
+HEXLIB_API int hl_line(int32_t q0, int32_t r0, int32_t q1, int32_t r1, int32_t* out, int max_out) {
+    if (!out) max_out = 0;
+    int steps = hex_distance(q0, r0, q1, r1);
+    for (int i = 0; i <= steps && i < max_out; ++i) hex_line_at(q0, r0, q1, r1, i, steps, &out[2 * i], &out[2 * i + 1]);
+    return steps + 1;
+}
+
+// --- Map generation ---
+// Fractal 2D simplex noise sampled at hex centers (flat-top layout in hex
+// units, whatever the grid's orientation, so a seed gives the same map
+// either way). Lattice gradients come from an integer hash of the corner and
+// the octave's seed instead of a permutation table, which keeps the SIMD
+// variants free of gathers. All variants do the same float operations in
+// the same order, so they agree bit for bit with the scalar one, and each
+// hex's value depends only on its coordinates.
+#define HL_NOISE_F2   0.36602540f  // (sqrt(3) - 1) / 2, skews onto the simplex lattice
+#define HL_NOISE_G2   0.21132487f  // (3 - sqrt(3)) / 6, unskews
+#define HL_NOISE_RUN  64           // hexes sampled per kernel call
+
+typedef struct {
+    uint32_t seeds[HL_MAX_NOISE_OCTAVES];
+    float    freqs[HL_MAX_NOISE_OCTAVES];
+    float    amps[HL_MAX_NOISE_OCTAVES];
+    int      octaves;
+    float    norm;  // 1 / sum of amps
+} HL_Noise;
+
+typedef void (*HL_NoiseFn)(const HL_Noise* n, int32_t q, int32_t r, int count, float* out);
+
+static uint32_t noise_hash(int32_t i, int32_t j, uint32_t seed) {
+    uint32_t h = ((uint32_t)i * 0x8da6b343u) ^ ((uint32_t)j * 0xd8163841u) ^ seed;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 13;
+    return h;
+}
+
+// Falloff times the dot with one of 8 gradients (+-1, +-2), (+-2, +-1)
+static float noise_corner(uint32_t h, float x, float y) {
+    float t = 0.5f - x * x - y * y;
+    float u = (h & 4) ? y : x;
+    float v = (h & 4) ? x : y;
+    if (h & 1) u = -u;
+    v = v + v;
+    if (h & 2) v = -v;
+    float t2 = t * t;
+    return t < 0.0f ? 0.0f : t2 * t2 * (u + v);
+}
+
+static float noise_simplex(float x, float y, uint32_t seed) {
+    float s = (x + y) * HL_NOISE_F2;
+    int32_t i = (int32_t)floorf(x + s);
+    int32_t j = (int32_t)floorf(y + s);
+    float t = (float)(i + j) * HL_NOISE_G2;
+    float x0 = x - ((float)i - t);
+    float y0 = y - ((float)j - t);
+    int32_t i1 = x0 > y0;
+    int32_t j1 = 1 - i1;
+    float x1 = x0 - (float)i1 + HL_NOISE_G2;
+    float y1 = y0 - (float)j1 + HL_NOISE_G2;
+    float x2 = x0 - 1.0f + 2.0f * HL_NOISE_G2;
+    float y2 = y0 - 1.0f + 2.0f * HL_NOISE_G2;
+    float n0 = noise_corner(noise_hash(i, j, seed), x0, y0);
+    float n1 = noise_corner(noise_hash(i + i1, j + j1, seed), x1, y1);
+    float n2 = noise_corner(noise_hash(i + 1, j + 1, seed), x2, y2);
+    return 40.0f * (n0 + n1 + n2);
+}
+
+// out[k] = noise at hex (q + k, r)
+static void noise_run_scalar(const HL_Noise* n, int32_t q, int32_t r, int count, float* out) {
+    for (int k = 0; k < count; ++k) {
+        float fq = (float)(q + k);
+        float x = 1.5f * fq;
+        float y = HL_SQRT3 * (0.5f * fq + (float)r);
+        float sum = 0.0f;
+        for (int o = 0; o < n->octaves; ++o) {
+            sum = sum + n->amps[o] * noise_simplex(x * n->freqs[o], y * n->freqs[o], n->seeds[o]);
+        }
+        out[k] = sum * n->norm;
+    }
+}
+
+#if HL_SIMD_SSE2
+// Low 32 bits of each lane's product; SSE2 only multiplies even lanes
+static __m128i noise_mullo_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static __m128i noise_hash_sse2(__m128i i, __m128i j, __m128i seed) {
+    __m128i h = _mm_xor_si128(_mm_xor_si128(noise_mullo_sse2(i, _mm_set1_epi32((int)0x8da6b343u)),
+                                            noise_mullo_sse2(j, _mm_set1_epi32((int)0xd8163841u))), seed);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = noise_mullo_sse2(h, _mm_set1_epi32(0x2c1b3c6d));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 13));
+}
+
+static __m128 noise_corner_sse2(__m128i h, __m128 x, __m128 y) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128 t = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), zero));
+    __m128 u = _mm_or_ps(_mm_and_ps(swap, x), _mm_andnot_ps(swap, y));
+    __m128 v = _mm_or_ps(_mm_and_ps(swap, y), _mm_andnot_ps(swap, x));
+    // Bits 0 and 1 of the hash become the sign bits of u and 2v
+    u = _mm_xor_ps(u, _mm_castsi128_ps(_mm_slli_epi32(h, 31)));
+    v = _mm_add_ps(v, v);
+    v = _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31)));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 c = _mm_mul_ps(_mm_mul_ps(t2, t2), _mm_add_ps(u, v));
+    return _mm_and_ps(c, _mm_cmpge_ps(t, _mm_setzero_ps()));
+}
+
+static __m128i noise_floor_sse2(__m128 v) {
+    __m128i i = _mm_cvttps_epi32(v);
+    return _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(i), v)));
+}
+
+static __m128 noise_simplex_sse2(__m128 x, __m128 y, __m128i seed) {
+    const __m128 g2 = _mm_set1_ps(HL_NOISE_G2);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i ione = _mm_set1_epi32(1);
+    __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(HL_NOISE_F2));
+    __m128i i = noise_floor_sse2(_mm_add_ps(x, s));
+    __m128i j = noise_floor_sse2(_mm_add_ps(y, s));
+    __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(i, j)), g2);
+    __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+    __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+    __m128 lower = _mm_cmpgt_ps(x0, y0);
+    __m128 i1 = _mm_and_ps(lower, one);
+    __m128 j1 = _mm_andnot_ps(lower, one);
+    __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+    __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+    __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), _mm_set1_ps(2.0f * HL_NOISE_G2));
+    __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), _mm_set1_ps(2.0f * HL_NOISE_G2));
+    __m128i ii1 = _mm_and_si128(_mm_castps_si128(lower), ione);
+    __m128i jj1 = _mm_andnot_si128(_mm_castps_si128(lower), ione);
+    __m128 n0 = noise_corner_sse2(noise_hash_sse2(i, j, seed), x0, y0);
+    __m128 n1 = noise_corner_sse2(noise_hash_sse2(_mm_add_epi32(i, ii1), _mm_add_epi32(j, jj1), seed), x1, y1);
+    __m128 n2 = noise_corner_sse2(noise_hash_sse2(_mm_add_epi32(i, ione), _mm_add_epi32(j, ione), seed), x2, y2);
+    return _mm_mul_ps(_mm_set1_ps(40.0f), _mm_add_ps(_mm_add_ps(n0, n1), n2));
+}
+
+static void noise_run_sse2(const HL_Noise* n, int32_t q, int32_t r, int count, float* out) {
+    const __m128 fr = _mm_set1_ps((float)r);
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m128 fq = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(q + k), _mm_setr_epi32(0, 1, 2, 3)));
+        __m128 x = _mm_mul_ps(_mm_set1_ps(1.5f), fq);
+        __m128 y = _mm_mul_ps(_mm_set1_ps(HL_SQRT3), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.5f), fq), fr));
+        __m128 sum = _mm_setzero_ps();
+        for (int o = 0; o < n->octaves; ++o) {
+            __m128 f = _mm_set1_ps(n->freqs[o]);
+            __m128 v = noise_simplex_sse2(_mm_mul_ps(x, f), _mm_mul_ps(y, f), _mm_set1_epi32((int)n->seeds[o]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(n->amps[o]), v));
+        }
+        _mm_storeu_ps(&out[k], _mm_mul_ps(sum, _mm_set1_ps(n->norm)));
+    }
+    noise_run_scalar(n, q + k, r, count - k, out + k);
+}
+#endif
+
+#if HL_SIMD_AVX2
+HL_TARGET_AVX2
+static __m256i noise_hash_avx2(__m256i i, __m256i j, __m256i seed) {
+    __m256i h = _mm256_xor_si256(_mm256_xor_si256(_mm256_mullo_epi32(i, _mm256_set1_epi32((int)0x8da6b343u)),
+                                                  _mm256_mullo_epi32(j, _mm256_set1_epi32((int)0xd8163841u))), seed);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x2c1b3c6d));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+}
+
+HL_TARGET_AVX2
+static __m256 noise_corner_avx2(__m256i h, __m256 x, __m256 y) {
+    __m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y));
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(4)), _mm256_setzero_si256()));
+    __m256 u = _mm256_blendv_ps(y, x, swap);
+    __m256 v = _mm256_blendv_ps(x, y, swap);
+    u = _mm256_xor_ps(u, _mm256_castsi256_ps(_mm256_slli_epi32(h, 31)));
+    v = _mm256_add_ps(v, v);
+    v = _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31)));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 c = _mm256_mul_ps(_mm256_mul_ps(t2, t2), _mm256_add_ps(u, v));
+    return _mm256_and_ps(c, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ));
+}
+
+HL_TARGET_AVX2
+static __m256 noise_simplex_avx2(__m256 x, __m256 y, __m256i seed) {
+    const __m256 g2 = _mm256_set1_ps(HL_NOISE_G2);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i ione = _mm256_set1_epi32(1);
+    __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(HL_NOISE_F2));
+    __m256i i = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(x, s)));
+    __m256i j = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(y, s)));
+    __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(i, j)), g2);
+    __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+    __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+    __m256 lower = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+    __m256 i1 = _mm256_and_ps(lower, one);
+    __m256 j1 = _mm256_andnot_ps(lower, one);
+    __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, i1), g2);
+    __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, j1), g2);
+    __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, one), _mm256_set1_ps(2.0f * HL_NOISE_G2));
+    __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, one), _mm256_set1_ps(2.0f * HL_NOISE_G2));
+    __m256i ii1 = _mm256_and_si256(_mm256_castps_si256(lower), ione);
+    __m256i jj1 = _mm256_andnot_si256(_mm256_castps_si256(lower), ione);
+    __m256 n0 = noise_corner_avx2(noise_hash_avx2(i, j, seed), x0, y0);
+    __m256 n1 = noise_corner_avx2(noise_hash_avx2(_mm256_add_epi32(i, ii1), _mm256_add_epi32(j, jj1), seed), x1, y1);
+    __m256 n2 = noise_corner_avx2(noise_hash_avx2(_mm256_add_epi32(i, ione), _mm256_add_epi32(j, ione), seed), x2, y2);
+    return _mm256_mul_ps(_mm256_set1_ps(40.0f), _mm256_add_ps(_mm256_add_ps(n0, n1), n2));
+}
+
+HL_TARGET_AVX2
+static void noise_run_avx2(const HL_Noise* n, int32_t q, int32_t r, int count, float* out) {
+    const __m256 fr = _mm256_set1_ps((float)r);
+    int k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256 fq = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(q + k), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        __m256 x = _mm256_mul_ps(_mm256_set1_ps(1.5f), fq);
+        __m256 y = _mm256_mul_ps(_mm256_set1_ps(HL_SQRT3), _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), fq), fr));
+        __m256 sum = _mm256_setzero_ps();
+        for (int o = 0; o < n->octaves; ++o) {
+            __m256 f = _mm256_set1_ps(n->freqs[o]);
+            __m256 v = noise_simplex_avx2(_mm256_mul_ps(x, f), _mm256_mul_ps(y, f), _mm256_set1_epi32((int)n->seeds[o]));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(n->amps[o]), v));
+        }
+        _mm256_storeu_ps(&out[k], _mm256_mul_ps(sum, _mm256_set1_ps(n->norm)));
+    }
+    noise_run_scalar(n, q + k, r, count - k, out + k);
+}
+#endif
+
+static HL_NoiseFn g_noise_run = NULL;  // picked on first use, like g_project_columns
+
+static void noise_select_kernel(void) {
+    g_noise_run = noise_run_scalar;
+#if HL_SIMD_SSE2
+    g_noise_run = noise_run_sse2;
+#endif
+#if HL_SIMD_AVX2
+    if (SDL_HasAVX2()) g_noise_run = noise_run_avx2;
+#endif
+}
+
+typedef struct {
+    const HL_MapGen* gen;
+    HL_Noise         noise;
+    int              rows;
+    HL_TileInstance* tiles;
+    int32_t*         out_terrain;
+    int              max_out;
+} HL_MapGenJob;
+
+// Row `row` of the region: its first hex and length, and the index of that
+// hex in row order
+static int mapgen_row(const HL_MapGen* gen, int row, int32_t* q, int32_t* r, long long* first) {
+    if (gen->shape == HL_REGION_RECTANGLE) {
+        *q = gen->q0;
+        *r = gen->r0 + row;
+        *first = (long long)row * gen->width;
+        return gen->width;
+    }
+    long long rad = gen->radius, k = row;
+    int dr = row - gen->radius;
+    *q = gen->q0 + (dr < 0 ? -gen->radius - dr : -gen->radius);
+    *r = gen->r0 + dr;
+    if (k <= rad) {
+        *first = k * (rad + 1) + k * (k - 1) / 2;
+    } else {
+        *first = rad * (rad + 1) + rad * (rad - 1) / 2 + (k - rad) * (3 * rad + 1) - (k - rad) * (rad + k - 1) / 2;
+    }
+    return 2 * gen->radius + 1 - (dr < 0 ? -dr : dr);
+}
+
+// One job per chunk row (HL_CHUNK_SIZE map rows)
+static void mapgen_job(void* ctx, int index, int thread) {
+    (void)thread;
+    HL_MapGenJob* job = (HL_MapGenJob*)ctx;
+    const HL_MapGen* gen = job->gen;
+    float values[HL_NOISE_RUN];
+    int row_end = (index + 1) * HL_CHUNK_SIZE;
+    if (row_end > job->rows) row_end = job->rows;
+    for (int row = index * HL_CHUNK_SIZE; row < row_end; ++row) {
+        int32_t q, r;
+        long long first;
+        int len = mapgen_row(gen, row, &q, &r, &first);
+        for (int k = 0; k < len; k += HL_NOISE_RUN) {
+            int n = len - k < HL_NOISE_RUN ? len - k : HL_NOISE_RUN;
+            g_noise_run(&job->noise, q + k, r, n, values);
+            for (int m = 0; m < n; ++m) {
+                int band = 0;
+                while (band + 1 < gen->band_count && values[m] >= gen->bands[band + 1].threshold) band++;
+                const HL_TerrainBand* b = &gen->bands[band];
+                long long at = first + k + m;
+                HL_TileInstance* t = &job->tiles[at];
+                t->q = q + k + m;
+                t->r = r;
+                t->terrain_tex = b->terrain_tex;
+                t->unit_tex = -1;
+                t->terrain_scale = b->terrain_scale;
+                t->unit_scale = 1.0f;
+                t->overlay = b->overlay;
+                t->offset_x = 0.0f;
+                t->offset_y = 0.0f;
+                if (job->out_terrain && at < job->max_out) job->out_terrain[at] = b->terrain_tex;
+            }
+        }
+    }
+}
+
+HEXLIB_API int hl_generate_map(const HL_MapGen* gen, int32_t* out_terrain, int max_out) {
+    if (!gen || !gen->bands || gen->band_count <= 0 || !(gen->frequency > 0.0f)) return 0;
+    long long count;
+    int rows;
+    if (gen->shape == HL_REGION_HEXAGON) {
+        if (gen->radius < 0) return 0;
+        count = 3LL * gen->radius * (gen->radius + 1) + 1;
+        rows = 2 * gen->radius + 1;
+    } else if (gen->shape == HL_REGION_RECTANGLE) {
+        if (gen->width <= 0 || gen->height <= 0) return 0;
+        count = (long long)gen->width * gen->height;
+        rows = gen->height;
+    } else {
+        return 0;
+    }
+    if (count > INT32_MAX / (int)sizeof(HL_TileInstance)) return 0;
+    if (!g_noise_run) noise_select_kernel();
+
+    HL_MapGenJob job;
+    memset(&job, 0, sizeof(job));
+    job.gen = gen;
+    job.rows = rows;
+    job.out_terrain = out_terrain;
+    job.max_out = out_terrain ? max_out : 0;
+    job.noise.octaves = gen->octaves < 1 ? 1 : (gen->octaves > HL_MAX_NOISE_OCTAVES ? HL_MAX_NOISE_OCTAVES : gen->octaves);
+    float freq = gen->frequency, amp = 1.0f, total = 0.0f;
+    for (int o = 0; o < job.noise.octaves; ++o) {
+        job.noise.seeds[o] = gen->seed + 0x9e3779b9u * (uint32_t)o;
+        job.noise.freqs[o] = freq;
+        job.noise.amps[o] = amp;
+        total += amp;
+        freq *= 2.0f;
+        amp *= 0.5f;
+    }
+    job.noise.norm = 1.0f / total;
+
+    job.tiles = hl_map_tiles((int)count);
+    if (!job.tiles) {
+        SDL_Log("Map generation: no memory for %lld tiles", count);
+        return 0;
+    }
+    pool_run(mapgen_job, &job, (rows + HL_CHUNK_SIZE - 1) / HL_CHUNK_SIZE);
+    return hl_commit_tiles((int)count) ? (int)count : 0;
+}
+
+// --- Animation ---
+// hl_step(dt) advances a clock that drives two kinds of animation with no
+// uploads from the embedder. Terrain animators are registered per terrain
+// texture slot. Before projection, the visible chunks' columns with an
+// animated slot get their offset and overlay recomputed from the stored tile
+// plus a sine wave whose phase steps with q and r. Columns out of view keep
+// stale values until they come back. Chunks with animated tiles are drawn
+// live, not from the retained cache. Unit tweens slide the unit of a
+// destination hex along a path of hexes. Until the tween ends, the tile's
+// own unit is not drawn and the tween draws it in between.
+#define HL_TWO_PI 6.28318531f
+
+typedef struct {
+    int32_t* path;       // (q, r) pairs, origin first
+    int      count;
+    float    duration;   // seconds
+    float    elapsed;
+    int      easing;     // HL_EASE_*
+} HL_Tween;
+
+static HL_TileAnimation g_anims[HL_MAX_TEXTURE_SLOTS];
+static uint8_t          g_anim_on[HL_MAX_TEXTURE_SLOTS];
+static int              g_anim_count = 0;       // slots with an animator
+static float            g_anim_reach = 0.0f;    // largest animated |offset|, world pixels
+static double           g_anim_time = 0.0;      // seconds of hl_step dt
+static uint8_t*         g_anim_bucket = NULL;   // per tile-index bucket: animated tiles on screen
+static int              g_anim_bucket_cap = 0;
+static HL_Tween*        g_tweens = NULL;
+static int              g_tween_count = 0;
+static int              g_tween_cap = 0;
+static HL_TileKey*      g_tween_keys = NULL;    // destination -> tween, 2 * g_tween_cap slots
+static int              g_tween_keys_used = 0;
+
+static void anim_free(void) {
+    for (int i = 0; i < g_tween_count; ++i) free(g_tweens[i].path);
+    free(g_tweens);
+    free(g_tween_keys);
+    g_tweens = NULL;
+    g_tween_keys = NULL;
+    g_tween_count = g_tween_cap = g_tween_keys_used = 0;
+    free(g_anim_bucket);
+    g_anim_bucket = NULL;
+    g_anim_bucket_cap = 0;
+}
+
+// Damage every chunk the tween's unit can be drawn over
+static void tween_damage(const HL_Tween* tw) {
+    for (int i = 0; i < tw->count; ++i) scene_damage_chunk(chunk_coord(tw->path[2 * i]), chunk_coord(tw->path[2 * i + 1]));
+}
+
+static const int32_t* tween_dest(const HL_Tween* tw) {
+    return &tw->path[2 * (tw->count - 1)];
+}
+
+static void tween_remove(int k) {
+    const int32_t* dest = tween_dest(&g_tweens[k]);
+    tile_lookup_remove(g_tween_keys, 2 * g_tween_cap, dest[0], dest[1], &g_tween_keys_used);
+    tween_damage(&g_tweens[k]);
+    free(g_tweens[k].path);
+    g_tweens[k] = g_tweens[--g_tween_count];
+    if (k < g_tween_count) {
+        dest = tween_dest(&g_tweens[k]);
+        tile_lookup_put(g_tween_keys, 2 * g_tween_cap, dest[0], dest[1], k, &g_tween_keys_used);
+    }
+}
+
+// Tween heading for (q, r), or -1
+static int tween_find(int32_t q, int32_t r) {
+    if (g_tween_count == 0) return -1;
+    uint32_t mask = (uint32_t)(2 * g_tween_cap) - 1;
+    for (uint32_t i = axial_hash(q, r) & mask;; i = (i + 1) & mask) {
+        const HL_TileKey* k = &g_tween_keys[i];
+        if (k->index < 0) return -1;
+        if (k->q == q && k->r == r) return k->index;
+    }
+}
+
+static float ease(int easing, float t) {
+    switch (easing) {
+        case HL_EASE_IN:     return t * t;
+        case HL_EASE_OUT:    return t * (2.0f - t);
+        case HL_EASE_IN_OUT: return t * t * (3.0f - 2.0f * t);
+        default:             return t;
+    }
+}
+
+// World position of a tween's unit
+static void tween_position(const HL_Tween* tw, float* x, float* y) {
+    float t = tw->duration > 0.0f ? fminf(tw->elapsed / tw->duration, 1.0f) : 1.0f;
+    float s = ease(tw->easing, t) * (float)(tw->count - 1);
+    int seg = (int)s;
+    if (seg > tw->count - 2) seg = tw->count - 2;
+    float f = s - (float)seg;
+    const int32_t* a = &tw->path[2 * seg];
+    float q = (float)a[0] + (float)(a[2] - a[0]) * f;
+    float r = (float)a[1] + (float)(a[3] - a[1]) * f;
+    *x = g_grid.size * (g_orient->f0 * q + g_orient->f1 * r) + g_grid.origin_x;
+    *y = g_grid.size * (g_orient->f2 * q + g_orient->f3 * r) + g_grid.origin_y;
+}
+
+// Advance the clock and retire finished tweens
+static void anim_advance(float dt) {
+    if (!(dt > 0.0f)) return;
+    g_anim_time += dt;
+    for (int k = 0; k < g_tween_count;) {
+        tween_damage(&g_tweens[k]);
+        g_tweens[k].elapsed += dt;
+        if (g_tweens[k].elapsed >= g_tweens[k].duration) tween_remove(k);
+        else ++k;
+    }
+}
+
+// Recompute the animated columns of the `chunks` visible chunks and flag
+// their buckets in g_anim_bucket. `moved`: the clock advanced, so damage them.
+static void anim_apply(int chunks, int moved) {
+    if (g_anim_bucket_cap < g_tile_index.bucket_cap) {
+        uint8_t* flags = (uint8_t*)heap_realloc(g_anim_bucket, (size_t)g_tile_index.bucket_cap);
+        if (!flags) return;
+        g_anim_bucket = flags;
+        g_anim_bucket_cap = g_tile_index.bucket_cap;
+    }
+    if (g_cols.count != g_tile_index.item_count) return;
+    // Each slot's clock phase once per frame; kept in [0, 2pi) so float
+    // precision does not decay as the clock runs
+    float phase[HL_MAX_TEXTURE_SLOTS];
+    for (int s = 0; s < HL_MAX_TEXTURE_SLOTS; ++s) {
+        if (g_anim_on[s]) phase[s] = (float)fmod(g_anim_time * g_anims[s].speed, (double)HL_TWO_PI);
+    }
+    for (int c = 0; c < chunks; ++c) {
+        int bucket = g_visible_chunks[c];
+        const HL_ChunkBucket* b = &g_tile_index.buckets[bucket];
+        int animated = 0;
+        for (int j = b->start; j < b->start + b->count; ++j) {
+            int slot = g_cols.terrain[j];
+            if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS || !g_anim_on[slot]) continue;
+            const HL_TileAnimation* a = &g_anims[slot];
+            const HL_TileInstance* t = &g_tiles[g_tile_index.order[j]];
+            float w = sinf(phase[slot] + a->phase_q * (float)g_cols.q[j] + a->phase_r * (float)g_cols.r[j]);
+            g_cols.offset_x[j] = t->offset_x + a->offset_x * w;
+            g_cols.offset_y[j] = t->offset_y + a->offset_y * w;
+            if (a->tint.a) {
+                // Tint pulses from 0 to tint.a over the stored overlay
+                HL_Color o = t->overlay;
+                int k = (int)((float)a->tint.a * (0.5f + 0.5f * w));
+                if (o.a) {
+                    o.r = (uint8_t)(o.r + ((int)a->tint.r - o.r) * k / 255);
+                    o.g = (uint8_t)(o.g + ((int)a->tint.g - o.g) * k / 255);
+                    o.b = (uint8_t)(o.b + ((int)a->tint.b - o.b) * k / 255);
+                    o.a = (uint8_t)(o.a + (255 - o.a) * k / 255);
+                } else {
+                    o.r = a->tint.r;
+                    o.g = a->tint.g;
+                    o.b = a->tint.b;
+                    o.a = (uint8_t)k;
+                }
+                g_cols.overlay[j] = o;
+            }
+            animated = 1;
+        }
+        g_anim_bucket[bucket] = (uint8_t)animated;
+        if (animated && moved) scene_damage_chunk(b->cq, b->cr);
+    }
+}
+
+HEXLIB_API int hl_set_terrain_animation(int slot, const HL_TileAnimation* anim) {
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
+    int was_on = g_anim_on[slot];
+    g_anim_on[slot] = anim != NULL;
+    if (anim) g_anims[slot] = *anim;
+    g_anim_count = 0;
+    g_anim_reach = 0.0f;
+    for (int s = 0; s < HL_MAX_TEXTURE_SLOTS; ++s) {
+        if (!g_anim_on[s]) continue;
+        g_anim_count++;
+        g_anim_reach = fmaxf(g_anim_reach, fmaxf(fabsf(g_anims[s].offset_x), fabsf(g_anims[s].offset_y)));
+    }
+    // Put the stored offsets and overlays back into the columns
+    if (was_on && !anim && g_cols.count == g_tile_index.item_count) tile_columns_build();
+    scene_damage_all();
+    return 1;
+}
+
+HEXLIB_API int hl_move_unit(const int32_t* path, int count, float seconds, int easing) {
+    if (!path || count < 2) return 0;
+    int32_t q0 = path[0], r0 = path[1];
+    int32_t q1 = path[2 * (count - 1)], r1 = path[2 * (count - 1) + 1];
+    map_touch(q0, r0);
+    map_touch(q1, r1);
+    int from = tile_lookup_find(q0, r0), to = tile_lookup_find(q1, r1);
+    if (to < 0) return 0;
+    if (from >= 0 && from != to && g_tiles[from].unit_tex >= 0) {
+        g_tiles[to].unit_tex = g_tiles[from].unit_tex;
+        g_tiles[to].unit_scale = g_tiles[from].unit_scale;
+        g_tiles[from].unit_tex = -1;
+        tile_track_extent(&g_tiles[to]);
+        tile_mark_dirty(from, HL_TILE_UNIT);
+        tile_mark_dirty(to, HL_TILE_UNIT);
+    } else if (g_tiles[to].unit_tex < 0) {
+        return 0;
+    }
+    // A unit re-ordered mid-move snaps to where it was heading first
+    int k = tween_find(q0, r0);
+    if (k >= 0) tween_remove(k);
+    k = tween_find(q1, r1);
+    if (k >= 0) tween_remove(k);
+    if (!(seconds > 0.0f)) return 1;
+    if (g_tween_count == g_tween_cap) {
+        int cap = g_tween_cap ? g_tween_cap * 2 : 16;
+        HL_Tween* grown = (HL_Tween*)heap_realloc(g_tweens, sizeof(HL_Tween) * cap);
+        if (!grown) return 1;
+        g_tweens = grown;
+        HL_TileKey* keys = (HL_TileKey*)heap_malloc(sizeof(HL_TileKey) * 2 * cap);
+        if (!keys) return 1;
+        for (int i = 0; i < 2 * cap; ++i) keys[i].index = -1;
+        g_tween_keys_used = 0;
+        for (int i = 0; i < g_tween_count; ++i) {
+            const int32_t* dest = tween_dest(&g_tweens[i]);
+            tile_lookup_put(keys, 2 * cap, dest[0], dest[1], i, &g_tween_keys_used);
+        }
+        free(g_tween_keys);
+        g_tween_keys = keys;
+        g_tween_cap = cap;
+    }
+    int32_t* copy = (int32_t*)heap_malloc(sizeof(int32_t) * 2 * (size_t)count);
+    if (!copy) return 1;
+    memcpy(copy, path, sizeof(int32_t) * 2 * (size_t)count);
+    HL_Tween* tw = &g_tweens[g_tween_count++];
+    tw->path = copy;
+    tw->count = count;
+    tw->duration = seconds;
+    tw->elapsed = 0.0f;
+    tw->easing = easing;
+    tile_lookup_put(g_tween_keys, 2 * g_tween_cap, q1, r1, g_tween_count - 1, &g_tween_keys_used);
+    tween_damage(tw);
+    return 1;
+}
+
+HEXLIB_API int hl_active_tweens(void) {
+    return g_tween_count;
+}
+
+// --- Tile drawing ---
+static const SDL_Color g_tile_fallback = { 70, 90, 110, 255 };  // tiles without a terrain texture
+
+static void texture_dest_rect(const HL_TextureSlot* slot, float target_w, float target_h, float cx, float cy, float scale_mul, SDL_FRect* out_rect) {
+    float w = target_w;
+    float h = target_h;
+    if (scale_mul <= 0.01f) scale_mul = 0.01f;
+    if (slot && slot->texture && slot->w > 0 && slot->h > 0) {
+        float scale = (target_w / (float)slot->w);
+        w = target_w * scale_mul;
+        h = (float)slot->h * scale * scale_mul;
         if (h < target_h * 0.92f) {
             float adjust = (target_h * 1.02f) / fmaxf(h, 1e-3f);
             w *= adjust;
             h *= adjust;
         }
     } else {
-        w = target_w * scale_mul;
-        h = target_h * scale_mul;
+        w = target_w * scale_mul;
+        h = target_h * scale_mul;
+    }
+    out_rect->w = w;
+    out_rect->h = h;
+    out_rect->x = cx - w * 0.5f;
+    out_rect->y = cy - h * 0.5f;
+}
+
+// --- Draw list ---
+// Tile primitives are recorded as commands with a 64-bit sort key, radix
+// sorted, then submitted in key order. The key packs, high to low,
+//   layer (8) | texture (16) | blend mode (8) | depth (32)
+// so a frame goes out layer by layer (terrain, overlays, units), each layer
+// texture by texture, and sprites sharing a texture are painted from the top
+// of the screen down. The batch flushes only when the texture changes, so
+// there is one submission per (layer, texture) however many tiles and units
+// are on screen.
+
+// Atlas pages sort before standalone textures; 0 is untextured geometry
+static uint64_t draw_texture_key(int slot) {
+    if (slot < 0) return 0;
+    return g_textures[slot].page >= 0 ? 1u + (uint64_t)g_textures[slot].page : 256u + (uint64_t)slot;
+}
+
+// Screen y as an order-preserving unsigned fixed-point value (1/4 px)
+static uint32_t draw_depth_key(float y) {
+    y = fminf(fmaxf(y, -1.0e8f), 1.0e8f);
+    return (uint32_t)((int32_t)floorf(y * 4.0f)) ^ 0x80000000u;
+}
+
+// Caller has reserved room
+static void draw_list_push(int layer, int slot, float depth, const SDL_FRect* dest, SDL_Color color) {
+    int n = g_draw_count++;
+    g_draw_cmds[n].key = ((uint64_t)layer << HL_KEY_LAYER_SHIFT) |
+                         (draw_texture_key(slot) << HL_KEY_TEXTURE_SHIFT) |
+                         ((uint64_t)SDL_BLENDMODE_BLEND << HL_KEY_BLEND_SHIFT) |
+                         draw_depth_key(depth);
+    g_draw_cmds[n].op = (uint32_t)n;
+    g_draw_ops[n].dest = *dest;
+    g_draw_ops[n].slot = slot;
+    g_draw_ops[n].color = color;
+}
+
+// Stable LSD radix sort on the key bytes, skipping bytes every key shares
+static void draw_list_sort(void) {
+    int n = g_draw_count;
+    if (n < 2) return;
+    static uint32_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < n; ++i) {
+        uint64_t key = g_draw_cmds[i].key;
+        for (int b = 0; b < 8; ++b) counts[b][(key >> (b * 8)) & 0xFF]++;
+    }
+    HL_DrawCmd* src = g_draw_cmds;
+    HL_DrawCmd* dst = g_draw_sorted;
+    for (int b = 0; b < 8; ++b) {
+        uint32_t* c = counts[b];
+        if (c[(src[0].key >> (b * 8)) & 0xFF] == (uint32_t)n) continue;
+        uint32_t offset = 0;
+        for (int d = 0; d < 256; ++d) {
+            uint32_t count = c[d];
+            c[d] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < n; ++i) dst[c[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+        HL_DrawCmd* t = src;
+        src = dst;
+        dst = t;
+    }
+    g_draw_cmds = src;
+    g_draw_sorted = dst;
+}
+
+static void draw_list_submit(void) {
+    static const SDL_Color white = { 255, 255, 255, 255 };
+    draw_list_sort();
+    for (int i = 0; i < g_draw_count; ++i) {
+        const HL_DrawOp* op = &g_draw_ops[g_draw_cmds[i].op];
+        if (op->slot < 0) {
+            if (op->slot == HL_DRAW_FILL) batch_hex_fill(op->dest.x, op->dest.y, op->color);
+            else batch_hex(op->dest.x, op->dest.y, op->color);
+            continue;
+        }
+        const HL_TextureSlot* ts = &g_textures[op->slot];
+        batch_quad(ts->texture, &op->dest, ts->u0, ts->v0, ts->u1, ts->v1, white);
+    }
+    batch_flush();
+    g_draw_count = 0;
+}
+
+// Draw the `layers` (HL_LAYER_TERRAIN / OVERLAYS / UNITS / FOG) of the `count` tile
+// columns in `items`, centered at `pos`. Terrain is the terrain sprite, or a
+// fallback hex for tiles without a terrain texture.
+static void draw_tiles(const int* items, const SDL_FPoint* pos, int count, uint32_t layers, float hex_w, float hex_h) {
+    static const SDL_Color white = { 255, 255, 255, 255 };
+    layers &= g_layers;
+    if (g_fog_view < 0) layers &= ~HL_LAYER_FOG;
+    int tweens = (layers & HL_LAYER_UNITS) ? g_tween_count : 0;
+    if (count < 0) count = 0;
+    if ((!count && !tweens) || !layers || !draw_list_reserve(count * 4 + tweens)) return;
+    for (int k = 0; k < count; ++k) {
+        int col = items[k];
+        SDL_FRect dest = { pos[k].x, pos[k].y, 0.0f, 0.0f };
+        if (layers & HL_LAYER_TERRAIN) {
+            int slot = g_cols.terrain[col];
+            if (slot >= 0 && slot < HL_MAX_TEXTURE_SLOTS && g_textures[slot].texture) {
+                float scale = g_cols.terrain_scale[col] > 0.0f ? g_cols.terrain_scale[col] : 1.0f;
+                SDL_FRect sprite;
+                texture_dest_rect(&g_textures[slot], hex_w, hex_h, pos[k].x, pos[k].y, scale, &sprite);
+                draw_list_push(HL_DRAW_TERRAIN, slot, sprite.y + sprite.h, &sprite, white);
+            } else {
+                draw_list_push(HL_DRAW_TERRAIN, -1, pos[k].y, &dest, g_tile_fallback);
+            }
+        }
+        if (layers & HL_LAYER_OVERLAYS) {
+            HL_Color c = g_cols.overlay[col];
+            if (c.a) {
+                SDL_Color overlay = { c.r, c.g, c.b, c.a };
+                draw_list_push(HL_DRAW_OVERLAY, -1, pos[k].y, &dest, overlay);
+            }
+        }
+        if (layers & HL_LAYER_UNITS) {
+            int slot = g_cols.unit[col];
+            // A sliding unit is drawn by its tween below
+            if (slot >= 0 && slot < HL_MAX_TEXTURE_SLOTS && g_textures[slot].texture &&
+                !(g_tween_count && tween_find(g_cols.q[col], g_cols.r[col]) >= 0)) {
+                float scale = g_cols.unit_scale[col] > 0.0f ? g_cols.unit_scale[col] : 0.7f;
+                SDL_FRect sprite;
+                texture_dest_rect(&g_textures[slot], hex_w, hex_h, pos[k].x, pos[k].y, scale, &sprite);
+                draw_list_push(HL_DRAW_UNIT, slot, sprite.y + sprite.h, &sprite, white);
+            }
+        }
+        if (layers & HL_LAYER_FOG) {
+            SDL_Color tint = fog_tint(g_cols.q[col], g_cols.r[col]);
+            if (tint.a) draw_list_push(HL_DRAW_FOG, HL_DRAW_FILL, pos[k].y, &dest, tint);
+        }
+    }
+    for (int k = 0; k < tweens; ++k) {
+        const HL_Tween* tw = &g_tweens[k];
+        const int32_t* last = tween_dest(tw);
+        int i = tile_lookup_find(last[0], last[1]);
+        if (i < 0) continue;
+        int slot = g_tiles[i].unit_tex;
+        if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS || !g_textures[slot].texture) continue;
+        float scale = g_tiles[i].unit_scale > 0.0f ? g_tiles[i].unit_scale : 0.7f;
+        float x, y;
+        tween_position(tw, &x, &y);
+        world_to_screen(&x, &y, g_output_w, g_output_h);
+        SDL_FRect sprite;
+        texture_dest_rect(&g_textures[slot], hex_w, hex_h, x, y, scale, &sprite);
+        draw_list_push(HL_DRAW_UNIT, slot, sprite.y + sprite.h, &sprite, white);
+    }
+    draw_list_submit();
+}
+
+// --- Level of detail ---
+// Tiers by on-screen hex radius. Below g_lod_flat_size a tile is one flat
+// hex in the average color of its unit or terrain texture, with the overlay
+// mixed in on the CPU: no sprites, outlines or labels. Below
+// g_lod_minimap_size the tile layer is drawn from a minimap texture with one
+// texel per hex. Each spatial-index bucket owns an 8x8 cell of it, and every
+// visible chunk is a single quad. The texels of a chunk are laid along its
+// axial axes, so the quad is the chunk's parallelogram, widened by half a hex.
+enum { HL_LOD_FULL, HL_LOD_FLAT, HL_LOD_MINIMAP };
+
+static float        g_lod_flat_size = 6.0f;
+static float        g_lod_minimap_size = 2.5f;
+static SDL_Texture* g_minimap = NULL;
+static SDL_Color*   g_minimap_pixels = NULL;  // RGBA32 copy of the texture
+static int          g_minimap_w = 0, g_minimap_h = 0;
+static int          g_minimap_cols = 0;       // bucket cells per texture row
+static int          g_minimap_buckets = 0;    // g_tile_index.bucket_cap the cells were laid out for
+static int          g_minimap_stale = 1;      // rebuild before the next use
+static int          g_minimap_row_lo = -1;    // rows written by index edits, uploaded by minimap_sync
+static int          g_minimap_row_hi = -1;
+static uint32_t     g_minimap_fog = 0;        // g_fog_version the texels were built with
+
+static int lod_tier(float hex_px) {
+    if (hex_px < g_lod_minimap_size) return HL_LOD_MINIMAP;
+    if (hex_px < g_lod_flat_size) return HL_LOD_FLAT;
+    return HL_LOD_FULL;
+}
+
+// Flat color of tile column `col`
+// Fully transparent when none of the tile's visible layers has anything to show
+static SDL_Color lod_color(int col) {
+    SDL_Color c = g_tile_fallback;
+    int base = (g_layers & HL_LAYER_TERRAIN) != 0;
+    int slot = (g_layers & HL_LAYER_UNITS) ? g_cols.unit[col] : -1;
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS || !g_textures[slot].texture) slot = base ? g_cols.terrain[col] : -1;
+    else base = 1;
+    if (slot >= 0 && slot < HL_MAX_TEXTURE_SLOTS && g_textures[slot].texture) c = g_textures[slot].average;
+    HL_Color o = g_cols.overlay[col];
+    if (!(g_layers & HL_LAYER_OVERLAYS)) o.a = 0;
+    if (!base) {
+        // Overlay alone (or nothing) over the background
+        c.r = o.r;
+        c.g = o.g;
+        c.b = o.b;
+        c.a = o.a;
+    } else {
+        if (o.a) {
+            c.r = (uint8_t)(c.r + ((int)o.r - c.r) * o.a / 255);
+            c.g = (uint8_t)(c.g + ((int)o.g - c.g) * o.a / 255);
+            c.b = (uint8_t)(c.b + ((int)o.b - c.b) * o.a / 255);
+        }
+        c.a = 255;
+    }
+    SDL_Color f = fog_tint(g_cols.q[col], g_cols.r[col]);
+    if (f.a && (g_layers & HL_LAYER_FOG)) {
+        if (!c.a) return f;
+        c.r = (uint8_t)(c.r + ((int)f.r - c.r) * f.a / 255);
+        c.g = (uint8_t)(c.g + ((int)f.g - c.g) * f.a / 255);
+        c.b = (uint8_t)(c.b + ((int)f.b - c.b) * f.a / 255);
+        c.a = (uint8_t)(c.a + (255 - c.a) * f.a / 255);
+    }
+    return c;
+}
+
+static void draw_tile_flat(const int* items, const SDL_FPoint* pos, int count) {
+    for (int k = 0; k < count; ++k) {
+        SDL_Color c = lod_color(items[k]);
+        if (c.a) batch_hex_fill(pos[k].x, pos[k].y, c);
+    }
+    batch_flush();
+}
+
+static void minimap_free(void) {
+    if (g_minimap) SDL_DestroyTexture(g_minimap);
+    g_minimap = NULL;
+    free(g_minimap_pixels);
+    g_minimap_pixels = NULL;
+    g_minimap_w = g_minimap_h = g_minimap_cols = 0;
+    g_minimap_stale = 1;
+}
+
+// The cells still follow the bucket slots, so index edits can patch texels
+static int minimap_current(void) {
+    return g_minimap && !g_minimap_stale && g_minimap_buckets == g_tile_index.bucket_cap;
+}
+
+static void minimap_touch_rows(int lo, int hi) {
+    if (g_minimap_row_lo < 0 || lo < g_minimap_row_lo) g_minimap_row_lo = lo;
+    if (hi > g_minimap_row_hi) g_minimap_row_hi = hi;
+}
+
+// Write the texel of tile column `col` (in bucket `bucket`); returns its texel index
+static int minimap_store(int bucket, int col) {
+    int32_t q = g_cols.q[col], r = g_cols.r[col];
+    int x = (bucket % g_minimap_cols) * HL_CHUNK_SIZE + (q - chunk_coord(q) * HL_CHUNK_SIZE);
+    int y = (bucket / g_minimap_cols) * HL_CHUNK_SIZE + (r - chunk_coord(r) * HL_CHUNK_SIZE);
+    int texel = y * g_minimap_w + x;
+    g_minimap_pixels[texel] = lod_color(col);
+    return texel;
+}
+
+// Clear the texel of a tile removed from bucket `bucket`
+static void minimap_clear_texel(int bucket, int32_t q, int32_t r) {
+    if (!minimap_current()) return;
+    int x = (bucket % g_minimap_cols) * HL_CHUNK_SIZE + (q - chunk_coord(q) * HL_CHUNK_SIZE);
+    int y = (bucket / g_minimap_cols) * HL_CHUNK_SIZE + (r - chunk_coord(r) * HL_CHUNK_SIZE);
+    memset(&g_minimap_pixels[y * g_minimap_w + x], 0, sizeof(SDL_Color));
+    minimap_touch_rows(y, y);
+}
+
+// spatial_remove_bucket moved a bucket from slot `from` to `to`: empty the
+// old cell and lay the bucket's tiles into the new one
+static void minimap_bucket_moved(int from, int to) {
+    if (!minimap_current()) return;
+    for (int k = 0; k < 2; ++k) {
+        int cell = k ? to : from;
+        int x = (cell % g_minimap_cols) * HL_CHUNK_SIZE, y = (cell / g_minimap_cols) * HL_CHUNK_SIZE;
+        for (int row = 0; row < HL_CHUNK_SIZE; ++row) {
+            memset(&g_minimap_pixels[(y + row) * g_minimap_w + x], 0, sizeof(SDL_Color) * HL_CHUNK_SIZE);
+        }
+        minimap_touch_rows(y, y + HL_CHUNK_SIZE - 1);
+    }
+    const HL_ChunkBucket* b = &g_tile_index.buckets[to];
+    for (int j = 0; j < b->count; ++j) minimap_store(to, b->start + j);
+}
+
+// Re-lay every bucket's texels, recreating the texture if the bucket table grew
+static int minimap_build(void) {
+    g_minimap_stale = 0;
+    g_minimap_fog = g_fog_version;
+    g_minimap_buckets = g_tile_index.bucket_cap;
+    g_minimap_row_lo = g_minimap_row_hi = -1;
+    if (g_tile_index.bucket_cap == 0) return 0;
+    int cols = 1;
+    while (cols * cols < g_tile_index.bucket_cap) cols++;
+    int rows = (g_tile_index.bucket_cap + cols - 1) / cols;
+    int w = cols * HL_CHUNK_SIZE, h = rows * HL_CHUNK_SIZE;
+    if (w != g_minimap_w || h != g_minimap_h) {
+        minimap_free();
+        g_minimap_stale = 0;
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(g_renderer, &info) == 0 &&
+            ((info.max_texture_width > 0 && w > info.max_texture_width) ||
+             (info.max_texture_height > 0 && h > info.max_texture_height))) return 0;
+        g_minimap_pixels = (SDL_Color*)heap_malloc(sizeof(SDL_Color) * (size_t)w * (size_t)h);
+        g_minimap = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, w, h);
+        if (!g_minimap_pixels || !g_minimap) {
+            SDL_Log("Minimap texture creation failed: %s", SDL_GetError());
+            minimap_free();
+            return 0;
+        }
+        SDL_SetTextureBlendMode(g_minimap, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(g_minimap, SDL_ScaleModeNearest);
+        g_minimap_w = w;
+        g_minimap_h = h;
+        g_minimap_cols = cols;
+    }
+    memset(g_minimap_pixels, 0, sizeof(SDL_Color) * (size_t)w * (size_t)h);
+    for (int i = 0; i < g_tile_index.bucket_cap; ++i) {
+        const HL_ChunkBucket* b = &g_tile_index.buckets[i];
+        for (int j = 0; j < b->count; ++j) minimap_store(i, b->start + j);
+    }
+    SDL_UpdateTexture(g_minimap, NULL, g_minimap_pixels, w * (int)sizeof(SDL_Color));
+    return 1;
+}
+
+// Bring the minimap up to date: rebuilt when stale, otherwise only the tiles
+// changed this frame are rewritten and their bounding rows re-uploaded
+static int minimap_sync(void) {
+    if (!minimap_current() || g_tile_dirty_all || g_minimap_fog != g_fog_version) return minimap_build();
+    int lo = g_minimap_row_lo, hi = g_minimap_row_hi;
+    g_minimap_row_lo = g_minimap_row_hi = -1;
+    for (int k = 0; k < g_tile_dirty_count; ++k) {
+        int i = g_tile_dirty_list[k];
+        if (!(g_tile_dirty[i] & (HL_TILE_TERRAIN | HL_TILE_UNIT | HL_TILE_OVERLAY))) continue;
+        const HL_ChunkBucket* b = spatial_find(&g_tile_index, chunk_coord(g_tiles[i].q), chunk_coord(g_tiles[i].r));
+        if (!b) continue;
+        int row = minimap_store((int)(b - g_tile_index.buckets), g_cols.column_of[i]) / g_minimap_w;
+        if (lo < 0 || row < lo) lo = row;
+        if (row > hi) hi = row;
+    }
+    if (lo >= 0) {
+        SDL_Rect rect = { 0, lo, g_minimap_w, hi - lo + 1 };
+        SDL_UpdateTexture(g_minimap, &rect, g_minimap_pixels + (size_t)lo * g_minimap_w, g_minimap_w * (int)sizeof(SDL_Color));
+    }
+    return 1;
+}
+
+// Called on frames drawn at another tier: remember whether the minimap missed a change
+static void minimap_note_changes(void) {
+    if (g_minimap_stale) return;
+    if (g_tile_dirty_all) {
+        g_minimap_stale = 1;
+        return;
+    }
+    for (int k = 0; k < g_tile_dirty_count && !g_minimap_stale; ++k) {
+        if (g_tile_dirty[g_tile_dirty_list[k]] & (HL_TILE_TERRAIN | HL_TILE_UNIT | HL_TILE_OVERLAY)) g_minimap_stale = 1;
+    }
+}
+
+// Draw the `chunks` buckets in g_visible_chunks from the minimap. Returns the
+// number of tiles they hold, or -1 if the minimap is unavailable.
+static int minimap_draw(const HL_Projection* p, int chunks) {
+    if (!minimap_sync()) return -1;
+    static const SDL_Color white = { 255, 255, 255, 255 };
+    float tw = 1.0f / (float)g_minimap_w, th = 1.0f / (float)g_minimap_h;
+    int tiles = 0;
+    for (int c = 0; c < chunks; ++c) {
+        int i = g_visible_chunks[c];
+        const HL_ChunkBucket* b = &g_tile_index.buckets[i];
+        float q0 = b->cq * HL_CHUNK_SIZE - 0.5f, r0 = b->cr * HL_CHUNK_SIZE - 0.5f;
+        float x = p->kx + q0 * p->qx + r0 * p->rx, y = p->ky + q0 * p->qy + r0 * p->ry;
+        float dqx = HL_CHUNK_SIZE * p->qx, dqy = HL_CHUNK_SIZE * p->qy;
+        float drx = HL_CHUNK_SIZE * p->rx, dry = HL_CHUNK_SIZE * p->ry;
+        SDL_FPoint corners[4] = {
+            { x, y }, { x + dqx, y + dqy }, { x + dqx + drx, y + dqy + dry }, { x + drx, y + dry },
+        };
+        float u0 = (float)((i % g_minimap_cols) * HL_CHUNK_SIZE) * tw;
+        float v0 = (float)((i / g_minimap_cols) * HL_CHUNK_SIZE) * th;
+        batch_quad_points(g_minimap, corners, u0, v0, u0 + HL_CHUNK_SIZE * tw, v0 + HL_CHUNK_SIZE * th, white);
+        tiles += b->count;
+    }
+    batch_flush();
+    return tiles;
+}
+
+// --- Retained chunk cache ---
+// With hl_set_retained_mode(1) the terrain layer (fallback hexes, terrain
+// sprites, overlays) of each spatial-index chunk is rendered once into a
+// target texture and composited under the camera transform, so a static map
+// costs one copy per visible chunk. A chunk is re-rendered when one of its
+// tiles changes or the zoom leaves the scale it was rendered at; chunks that
+// change every frame (animated offsets, hover overlays) are drawn live.
+#define HL_CHUNK_CACHE_TEXELS     (32 * 1024 * 1024)  // budget across all chunk textures
+#define HL_CHUNK_BUILDS_PER_FRAME 4
+#define HL_CHUNK_HOT_STREAK       4   // consecutive dirty frames before a chunk is drawn live
+
+typedef struct {
+    int32_t      cq, cr;
+    int          used;           // slot holds a key
+    int          valid;          // texture matches the chunk's tiles
+    SDL_Texture* texture;
+    int          tex_w, tex_h;   // allocated size
+    int          pix_w, pix_h;   // area covered by the last render
+    float        world_x, world_y, world_w, world_h;
+    float        scale;          // texels per world unit
+    uint32_t     last_used;      // frame indices
+    uint32_t     last_dirty;
+    int          streak;         // consecutive frames the chunk was invalidated
+} HL_ChunkCache;
+
+static int            g_retained = 0;
+static HL_ChunkCache* g_chunk_cache = NULL;
+static int            g_chunk_cache_cap = 0;    // power of two
+static int            g_chunk_cache_used = 0;
+static long long      g_chunk_cache_texels = 0;
+static int            g_chunk_max_texture = 4096;
+static SDL_BlendMode  g_chunk_blend = SDL_BLENDMODE_BLEND;
+static HL_Grid        g_chunk_grid = {0};       // grid and sprite overhang the cache was rendered for
+static float          g_chunk_overhang = -1.0f;
+static SDL_FPoint*    g_chunk_pos = NULL;     // chunk-local tile centers while rendering a chunk
+static int*           g_chunk_items = NULL;   // columns of that chunk
+static int            g_chunk_pos_cap = 0;    // capacity of both
+static uint32_t       g_frame_index = 0;
+
+static HL_ChunkCache* chunk_cache_find(int32_t cq, int32_t cr, int create) {
+    if (create && (g_chunk_cache_used + 1) * 2 > g_chunk_cache_cap) {
+        int cap = g_chunk_cache_cap ? g_chunk_cache_cap * 2 : 64;
+        HL_ChunkCache* table = (HL_ChunkCache*)heap_calloc((size_t)cap, sizeof(HL_ChunkCache));
+        if (!table) return NULL;
+        for (int i = 0; i < g_chunk_cache_cap; ++i) {
+            const HL_ChunkCache* e = &g_chunk_cache[i];
+            if (!e->used) continue;
+            uint32_t j = axial_hash(e->cq, e->cr) & (uint32_t)(cap - 1);
+            while (table[j].used) j = (j + 1) & (uint32_t)(cap - 1);
+            table[j] = *e;
+        }
+        free(g_chunk_cache);
+        g_chunk_cache = table;
+        g_chunk_cache_cap = cap;
+    }
+    if (!g_chunk_cache) return NULL;
+    uint32_t mask = (uint32_t)g_chunk_cache_cap - 1;
+    for (uint32_t i = axial_hash(cq, cr) & mask;; i = (i + 1) & mask) {
+        HL_ChunkCache* e = &g_chunk_cache[i];
+        if (e->used && e->cq == cq && e->cr == cr) return e;
+        if (e->used) continue;
+        if (!create) return NULL;
+        e->used = 1;
+        e->cq = cq;
+        e->cr = cr;
+        g_chunk_cache_used++;
+        return e;
+    }
+}
+
+static void chunk_cache_drop_texture(HL_ChunkCache* e) {
+    if (e->texture) {
+        SDL_DestroyTexture(e->texture);
+        g_chunk_cache_texels -= (long long)e->tex_w * e->tex_h;
+    }
+    e->texture = NULL;
+    e->tex_w = e->tex_h = 0;
+    e->valid = 0;
+}
+
+static void chunk_cache_mark(HL_ChunkCache* e) {
+    if (e->last_dirty == g_frame_index) return;
+    e->streak = (e->last_dirty + 1 == g_frame_index) ? e->streak + 1 : 1;
+    e->last_dirty = g_frame_index;
+    e->valid = 0;
+}
+
+static void chunk_cache_invalidate(int32_t q, int32_t r) {
+    HL_ChunkCache* e = chunk_cache_find(chunk_coord(q), chunk_coord(r), 0);
+    if (e) chunk_cache_mark(e);
+}
+
+static void chunk_cache_invalidate_all(void) {
+    for (int i = 0; i < g_chunk_cache_cap; ++i) {
+        if (g_chunk_cache[i].used) chunk_cache_mark(&g_chunk_cache[i]);
+    }
+}
+
+static void chunk_cache_free(void) {
+    for (int i = 0; i < g_chunk_cache_cap; ++i) {
+        if (g_chunk_cache[i].used) chunk_cache_drop_texture(&g_chunk_cache[i]);
+    }
+    free(g_chunk_cache);
+    g_chunk_cache = NULL;
+    g_chunk_cache_cap = 0;
+    g_chunk_cache_used = 0;
+    g_chunk_cache_texels = 0;
+    free(g_chunk_pos);
+    g_chunk_pos = NULL;
+    free(g_chunk_items);
+    g_chunk_items = NULL;
+    g_chunk_pos_cap = 0;
+    g_chunk_overhang = -1.0f;
+}
+
+// Free textures of chunks not drawn this frame, least recently used first,
+// until `texels` more fit in the budget.
+static int chunk_cache_evict(long long texels) {
+    while (g_chunk_cache_texels + texels > HL_CHUNK_CACHE_TEXELS) {
+        HL_ChunkCache* victim = NULL;
+        for (int i = 0; i < g_chunk_cache_cap; ++i) {
+            HL_ChunkCache* e = &g_chunk_cache[i];
+            if (!e->used || !e->texture || e->last_used == g_frame_index) continue;
+            if (!victim || e->last_used < victim->last_used) victim = e;
+        }
+        if (!victim) return 0;
+        chunk_cache_drop_texture(victim);
+    }
+    return 1;
+}
+
+// Render the terrain layer of one chunk into its texture at `scale` texels
+// per world unit. The texture covers the chunk's (offset) tile centers padded
+// by `overhang`, so sprites reaching past the chunk edge are kept whole.
+static int chunk_cache_render(HL_ChunkCache* e, const HL_ChunkBucket* b, float overhang, float scale) {
+    if (g_chunk_pos_cap < b->count) {
+        SDL_FPoint* pos = (SDL_FPoint*)heap_realloc(g_chunk_pos, sizeof(SDL_FPoint) * b->count);
+        if (!pos) return 0;
+        g_chunk_pos = pos;
+        int* items = (int*)heap_realloc(g_chunk_items, sizeof(int) * b->count);
+        if (!items) return 0;
+        g_chunk_items = items;
+        g_chunk_pos_cap = b->count;
+    }
+    float x0 = 0.0f, y0 = 0.0f, x1 = 0.0f, y1 = 0.0f;
+    for (int k = 0; k < b->count; ++k) {
+        int j = b->start + k;
+        float cx, cy;
+        axial_to_pixel(g_cols.q[j], g_cols.r[j], g_grid.size, &cx, &cy);
+        cx += g_cols.offset_x[j];
+        cy += g_cols.offset_y[j];
+        g_chunk_items[k] = j;
+        g_chunk_pos[k].x = cx;
+        g_chunk_pos[k].y = cy;
+        if (k == 0 || cx < x0) x0 = cx;
+        if (k == 0 || cy < y0) y0 = cy;
+        if (k == 0 || cx > x1) x1 = cx;
+        if (k == 0 || cy > y1) y1 = cy;
+    }
+    float pad = overhang + g_grid.size;
+    x0 -= pad; y0 -= pad;
+    x1 += pad; y1 += pad;
+    int pw = (int)ceilf((x1 - x0) * scale);
+    int ph = (int)ceilf((y1 - y0) * scale);
+    if (pw <= 0 || ph <= 0 || pw > g_chunk_max_texture || ph > g_chunk_max_texture) return 0;
+
+    if (!e->texture || e->tex_w < pw || e->tex_h < ph) {
+        chunk_cache_drop_texture(e);
+        if (!chunk_cache_evict((long long)pw * ph)) return 0;
+        e->texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, pw, ph);
+        if (!e->texture) {
+            SDL_Log("Chunk texture %dx%d failed: %s", pw, ph, SDL_GetError());
+            return 0;
+        }
+        // Target contents are premultiplied; renderers without custom blend
+        // modes fall back to plain blending (slightly darker soft edges).
+        if (SDL_SetTextureBlendMode(e->texture, g_chunk_blend) != 0) {
+            g_chunk_blend = SDL_BLENDMODE_BLEND;
+            SDL_SetTextureBlendMode(e->texture, g_chunk_blend);
+        }
+        SDL_SetTextureScaleMode(e->texture, SDL_ScaleModeLinear);
+        e->tex_w = pw;
+        e->tex_h = ph;
+        g_chunk_cache_texels += (long long)pw * ph;
+    }
+
+    for (int k = 0; k < b->count; ++k) {
+        g_chunk_pos[k].x = (g_chunk_pos[k].x - x0) * scale;
+        g_chunk_pos[k].y = (g_chunk_pos[k].y - y0) * scale;
+    }
+    if (SDL_SetRenderTarget(g_renderer, e->texture) != 0) return 0;
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(g_renderer);
+    float size = g_grid.size * scale;
+    update_corner_offsets(size);
+    float hex_w, hex_h;
+    hex_bounds(size, &hex_w, &hex_h);
+    draw_tiles(g_chunk_items, g_chunk_pos, b->count, HL_LAYER_TERRAIN | HL_LAYER_OVERLAYS, hex_w, hex_h);
+    SDL_SetRenderTarget(g_renderer, NULL);
+
+    e->pix_w = pw;
+    e->pix_h = ph;
+    e->world_x = x0;
+    e->world_y = y0;
+    e->world_w = pw / scale;
+    e->world_h = ph / scale;
+    e->scale = scale;
+    e->valid = 1;
+    return 1;
+}
+
+// Invalidate chunks touched since the last frame and re-render the stale
+// visible ones (up to HL_CHUNK_BUILDS_PER_FRAME). Runs before the frame is
+// cleared so no backend has to preserve the back buffer across target
+// switches. `reach` culls chunks; `overhang` is the sprite part of it (tile
+// offsets are baked into each chunk's bounds). Leaves the visible chunks in
+// g_visible_chunks and returns their count.
+static int chunk_cache_prepare(int win_w, int win_h, float reach, float overhang, float zoom) {
+    if (overhang != g_chunk_overhang || memcmp(&g_grid, &g_chunk_grid, sizeof(HL_Grid)) != 0) {
+        chunk_cache_invalidate_all();
+        g_chunk_overhang = overhang;
+        g_chunk_grid = g_grid;
+    }
+    if (g_tile_dirty_all) {
+        chunk_cache_invalidate_all();
+    } else {
+        for (int k = 0; k < g_tile_dirty_count; ++k) {
+            int i = g_tile_dirty_list[k];
+            if (g_tile_dirty[i] & (HL_TILE_TERRAIN | HL_TILE_OVERLAY | HL_TILE_OFFSET)) {
+                chunk_cache_invalidate(g_tiles[i].q, g_tiles[i].r);
+            }
+        }
+    }
+
+    int chunks = spatial_query_chunks(&g_tile_index, win_w, win_h, reach);
+    // Render scale in half-octave steps at or above the zoom, so composites
+    // are only ever minified and small zoom changes reuse the textures
+    float scale = exp2f(ceilf(log2f(zoom) * 2.0f) * 0.5f);
+    int builds = 0;
+    for (int c = 0; c < chunks; ++c) {
+        const HL_ChunkBucket* b = &g_tile_index.buckets[g_visible_chunks[c]];
+        HL_ChunkCache* e = chunk_cache_find(b->cq, b->cr, 1);
+        if (!e) continue;
+        e->last_used = g_frame_index;
+        if (g_anim_count && g_anim_bucket && g_anim_bucket[g_visible_chunks[c]]) {
+            // Animated tiles move every frame: draw the chunk live
+            e->valid = 0;
+            continue;
+        }
+        if (e->valid && e->scale == scale) continue;
+        if (!e->valid && e->streak >= HL_CHUNK_HOT_STREAK && e->last_dirty == g_frame_index) continue;
+        if (builds >= HL_CHUNK_BUILDS_PER_FRAME) continue;
+        builds++;
+        // A rebuild after a zoom change replaces a stretched texture on screen
+        if (!chunk_cache_render(e, b, overhang, scale)) chunk_cache_drop_texture(e);
+        else scene_damage_chunk(b->cq, b->cr);
+    }
+    return chunks;
+}
+
+// Composite the cached visible chunks. A valid texture rendered at another
+// scale is still drawn (stretched) until it is rebuilt. Tiles of chunks with
+// no usable texture are projected into g_visible/g_screen_pos for live
+// drawing; returns how many of those are on screen.
+static int chunk_cache_draw(int chunks, const HL_Projection* p, int win_w, int win_h, float zoom) {
+    if (g_cols.count != g_tile_index.item_count || !projection_reserve(g_cols.count)) return 0;
+    int live = 0;
+    for (int c = 0; c < chunks; ++c) {
+        const HL_ChunkBucket* b = &g_tile_index.buckets[g_visible_chunks[c]];
+        const HL_ChunkCache* e = chunk_cache_find(b->cq, b->cr, 0);
+        if (e && e->valid) {
+            float x = e->world_x, y = e->world_y;
+            world_to_screen(&x, &y, win_w, win_h);
+            SDL_Rect src = { 0, 0, e->pix_w, e->pix_h };
+            SDL_FRect dest = { x, y, e->world_w * zoom, e->world_h * zoom };
+            SDL_RenderCopyF(g_renderer, e->texture, &src, &dest);
+            HL_STAT_ADD(copy_calls, 1);
+            HL_STAT_ADD(hexes_drawn, (uint32_t)b->count);
+            continue;
+        }
+        live = g_project_columns(p, b->start, b->count, live);
+    }
+    return live;
+}
+
+HEXLIB_API void hl_set_lod(float flat_size, float minimap_size) {
+    flat_size = flat_size > 0.0f ? flat_size : 0.0f;
+    minimap_size = minimap_size > 0.0f ? minimap_size : 0.0f;
+    if (flat_size == g_lod_flat_size && minimap_size == g_lod_minimap_size) return;
+    g_lod_flat_size = flat_size;
+    g_lod_minimap_size = minimap_size;
+    scene_damage_all();
+}
+
+HEXLIB_API void hl_set_visible_layers(uint32_t layers) {
+    layers &= HL_LAYER_ALL;
+    if (layers == g_layers) return;
+    g_layers = layers;
+    // Cached chunks and minimap texels bake in the layers they were drawn with
+    chunk_cache_invalidate_all();
+    g_minimap_stale = 1;
+    scene_damage_all();
+}
+
+HEXLIB_API uint32_t hl_get_visible_layers(void) {
+    return g_layers;
+}
+
+static void retained_mode_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_set_retained_mode(c->a);
+}
+
+HEXLIB_API int hl_set_retained_mode(int enabled) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { enabled, 0, 0, NULL, NULL, 0 };
+        render_call(retained_mode_call, &c);
+        return c.result;
+    }
+    if (!enabled) {
+        chunk_cache_free();
+        if (g_retained) scene_damage_all();
+        g_retained = 0;
+        return 1;
+    }
+    if (!g_renderer || !SDL_RenderTargetSupported(g_renderer)) {
+        SDL_Log("Retained mode needs render target support");
+        return 0;
+    }
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(g_renderer, &info) == 0 && info.max_texture_width > 0) {
+        g_chunk_max_texture = info.max_texture_width < info.max_texture_height ? info.max_texture_width : info.max_texture_height;
+    }
+    g_chunk_blend = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (!g_retained) scene_damage_all();
+    g_retained = 1;
+    return 1;
+}
+
+// --- Texture atlas ---
+// Loaded slots are packed into a few large pages with a shelf packer so that
+// terrain and unit sprites can be drawn as textured geometry batches: one
+// SDL_RenderGeometry call per page rather than one blit per sprite. Images
+// that do not fit a page keep a standalone texture and are batched on their own.
+#define HL_ATLAS_MAX_PAGES   8
+#define HL_ATLAS_MAX_SHELVES 128
+#define HL_ATLAS_PAGE_SIZE   2048
+#define HL_ATLAS_PADDING     1   // edge pixels are extruded into the padding to stop bleeding
+
+typedef struct {
+    int y, h;    // vertical band of the page
+    int x;       // next free column
+} HL_Shelf;
+
+typedef struct {
+    SDL_Texture* texture;
+    int w, h;
+    HL_Shelf shelves[HL_ATLAS_MAX_SHELVES];
+    int shelf_count;
+    int used_h;  // bottom edge of the last shelf
+} HL_AtlasPage;
+
+static HL_AtlasPage g_atlas[HL_ATLAS_MAX_PAGES];
+static int          g_atlas_page_count = 0;
+
+static void atlas_destroy_pages(void) {
+    for (int i = 0; i < g_atlas_page_count; ++i) {
+        if (g_atlas[i].texture) SDL_DestroyTexture(g_atlas[i].texture);
+    }
+    memset(g_atlas, 0, sizeof(g_atlas));
+    g_atlas_page_count = 0;
+}
+
+static int atlas_add_page(void) {
+    if (g_atlas_page_count >= HL_ATLAS_MAX_PAGES) return -1;
+    int size = HL_ATLAS_PAGE_SIZE;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(g_renderer, &info) == 0) {
+        if (info.max_texture_width > 0 && info.max_texture_width < size) size = info.max_texture_width;
+        if (info.max_texture_height > 0 && info.max_texture_height < size) size = info.max_texture_height;
+    }
+    SDL_Texture* tex = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, size, size);
+    if (!tex) {
+        SDL_Log("Atlas page creation failed: %s", SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    HL_AtlasPage* page = &g_atlas[g_atlas_page_count];
+    memset(page, 0, sizeof(*page));
+    page->texture = tex;
+    page->w = size;
+    page->h = size;
+    return g_atlas_page_count++;
+}
+
+// Best-fit shelf allocation of a w x h cell; opens a new shelf if none fits
+static int atlas_page_alloc(HL_AtlasPage* page, int w, int h, int* out_x, int* out_y) {
+    if (w > page->w || h > page->h) return 0;
+    HL_Shelf* best = NULL;
+    for (int i = 0; i < page->shelf_count; ++i) {
+        HL_Shelf* shelf = &page->shelves[i];
+        if (shelf->h < h || page->w - shelf->x < w) continue;
+        if (!best || shelf->h < best->h) best = shelf;
+    }
+    if (!best) {
+        if (page->shelf_count >= HL_ATLAS_MAX_SHELVES || page->used_h + h > page->h) return 0;
+        best = &page->shelves[page->shelf_count++];
+        best->y = page->used_h;
+        best->h = h;
+        best->x = 0;
+        page->used_h += h;
+    }
+    *out_x = best->x;
+    *out_y = best->y;
+    best->x += w;
+    return 1;
+}
+
+// Copy the slot's pixels into the page with a replicated-edge border
+static int atlas_upload(const HL_AtlasPage* page, int x, int y, const SDL_Surface* surf) {
+    const int pad = HL_ATLAS_PADDING;
+    int w = surf->w + pad * 2;
+    int h = surf->h + pad * 2;
+    uint32_t* buf = (uint32_t*)heap_malloc(sizeof(uint32_t) * (size_t)w * (size_t)h);
+    if (!buf) return 0;
+    for (int row = 0; row < h; ++row) {
+        int sy = row - pad;
+        if (sy < 0) sy = 0;
+        if (sy >= surf->h) sy = surf->h - 1;
+        const uint32_t* src = (const uint32_t*)((const uint8_t*)surf->pixels + (size_t)sy * surf->pitch);
+        uint32_t* dst = buf + (size_t)row * w;
+        for (int i = 0; i < pad; ++i) {
+            dst[i] = src[0];
+            dst[w - 1 - i] = src[surf->w - 1];
+        }
+        memcpy(dst + pad, src, sizeof(uint32_t) * surf->w);
+    }
+    SDL_Rect rect = { x, y, w, h };
+    int ok = SDL_UpdateTexture(page->texture, &rect, buf, w * (int)sizeof(uint32_t)) == 0;
+    free(buf);
+    return ok;
+}
+
+// Place a loaded slot into the atlas, falling back to a standalone texture
+static int atlas_place_slot(int slot) {
+    HL_TextureSlot* ts = &g_textures[slot];
+    SDL_Surface* surf = ts->surface;
+    int cell_w = surf->w + HL_ATLAS_PADDING * 2;
+    int cell_h = surf->h + HL_ATLAS_PADDING * 2;
+    for (int p = 0; p <= g_atlas_page_count; ++p) {
+        int fresh = p == g_atlas_page_count;
+        if (fresh && atlas_add_page() < 0) break;
+        int x, y;
+        if (!atlas_page_alloc(&g_atlas[p], cell_w, cell_h, &x, &y)) {
+            if (fresh) break;  // larger than a whole page
+            continue;
+        }
+        if (!atlas_upload(&g_atlas[p], x, y, surf)) break;
+        float pw = (float)g_atlas[p].w, ph = (float)g_atlas[p].h;
+        ts->texture = g_atlas[p].texture;
+        ts->page = p;
+        ts->u0 = (x + HL_ATLAS_PADDING) / pw;
+        ts->v0 = (y + HL_ATLAS_PADDING) / ph;
+        ts->u1 = (x + HL_ATLAS_PADDING + surf->w) / pw;
+        ts->v1 = (y + HL_ATLAS_PADDING + surf->h) / ph;
+        return 1;
+    }
+
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(g_renderer, surf);
+    if (!tex) {
+        SDL_Log("SDL_CreateTextureFromSurface failed for slot %d: %s", slot, SDL_GetError());
+        return 0;
+    }
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    ts->texture = tex;
+    ts->page = -1;
+    ts->u0 = 0.0f; ts->v0 = 0.0f;
+    ts->u1 = 1.0f; ts->v1 = 1.0f;
+    return 1;
+}
+
+static void release_slot_texture(HL_TextureSlot* ts) {
+    if (ts->texture && ts->page < 0) SDL_DestroyTexture(ts->texture);
+    ts->texture = NULL;
+    ts->page = -1;
+}
+
+static void destroy_texture_slot(int slot) {
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return;
+    if (g_textures[slot].texture) {
+        chunk_cache_invalidate_all();
+        scene_damage_all();
+    }
+    // The slot's atlas cell is reclaimed the next time the atlas is rebuilt
+    release_slot_texture(&g_textures[slot]);
+    if (g_textures[slot].surface) {
+        SDL_FreeSurface(g_textures[slot].surface);
+        g_textures[slot].surface = NULL;
+    }
+    g_textures[slot].w = 0;
+    g_textures[slot].h = 0;
+    g_minimap_stale = 1;
+}
+
+static void build_atlas_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_build_atlas();
+}
+
+HEXLIB_API int hl_build_atlas(void) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { 0, 0, 0, NULL, NULL, 0 };
+        render_call(build_atlas_call, &c);
+        return c.result;
+    }
+    if (!g_renderer) return 0;
+    chunk_cache_invalidate_all();
+    scene_damage_all();
+    for (int i = 0; i < HL_MAX_TEXTURE_SLOTS; ++i) release_slot_texture(&g_textures[i]);
+    atlas_destroy_pages();
+
+    // Tallest first keeps shelves tight
+    int order[HL_MAX_TEXTURE_SLOTS];
+    int n = 0;
+    for (int i = 0; i < HL_MAX_TEXTURE_SLOTS; ++i) {
+        if (!g_textures[i].surface) continue;
+        int j = n++;
+        while (j > 0 && g_textures[order[j-1]].h < g_textures[i].h) {
+            order[j] = order[j-1];
+            --j;
+        }
+        order[j] = i;
+    }
+    for (int k = 0; k < n; ++k) {
+        if (!atlas_place_slot(order[k])) destroy_texture_slot(order[k]);
+    }
+    return g_atlas_page_count;
+}
+
+// Replace `slot` with a decoded RGBA32 surface, which the slot takes over
+static int texture_install(int slot, SDL_Surface* rgba) {
+    destroy_texture_slot(slot);
+    HL_TextureSlot* ts = &g_textures[slot];
+    ts->surface = rgba;
+    ts->w = rgba->w;
+    ts->h = rgba->h;
+    // Alpha-weighted mean color for the flat and minimap LOD tiers
+    uint64_t sum[4] = { 0, 0, 0, 0 };
+    for (int y = 0; y < rgba->h; ++y) {
+        const uint8_t* px = (const uint8_t*)rgba->pixels + (size_t)y * rgba->pitch;
+        for (int x = 0; x < rgba->w; ++x, px += 4) {
+            sum[0] += (uint64_t)px[0] * px[3];
+            sum[1] += (uint64_t)px[1] * px[3];
+            sum[2] += (uint64_t)px[2] * px[3];
+            sum[3] += px[3];
+        }
+    }
+    if (sum[3] > 0) {
+        ts->average.r = (uint8_t)(sum[0] / sum[3]);
+        ts->average.g = (uint8_t)(sum[1] / sum[3]);
+        ts->average.b = (uint8_t)(sum[2] / sum[3]);
+    } else {
+        ts->average = g_tile_fallback;
     }
-    out_rect->w = w;
-    out_rect->h = h;
-    out_rect->x = cx - w * 0.5f;
-    out_rect->y = cy - h * 0.5f;
+    ts->average.a = 255;
+    g_minimap_stale = 1;
+    if (!atlas_place_slot(slot)) {
+        destroy_texture_slot(slot);
+        return 0;
+    }
+    chunk_cache_invalidate_all();
+    scene_damage_all();
+    return 1;
 }
 
-HEXLIB_API void hl_step(float dt_seconds) {
-    (void)dt_seconds;
+static void texture_install_job(HL_LoadJob* job) {
+    int slot = job->slot;
+    if (job->generation == g_load_generation[slot]) {
+        int ok = job->surface && texture_install(slot, job->surface);
+        job->surface = NULL;  // owned by the slot now (or freed by it)
+        g_load_state[slot] = ok ? HL_LOAD_IDLE : HL_LOAD_FAILED;
+    }
+    load_job_free(job);
+}
 
-    SDL_SetRenderDrawColor(g_renderer, g_clear.r, g_clear.g, g_clear.b, g_clear.a);
-    SDL_RenderClear(g_renderer);
+// Install finished async loads, oldest first, until budget_ms has passed.
+// At least one is installed per call so loading always makes progress.
+static void texture_uploads(float budget_ms) {
+    if (!g_load_thread_count) return;
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = (Uint64)((double)budget_ms * 0.001 * (double)SDL_GetPerformanceFrequency());
+    HL_LoadJob* job;
+    while ((job = loader_take_done(-1)) != NULL) {
+        texture_install_job(job);
+        if (SDL_GetPerformanceCounter() - start >= budget) break;
+    }
+}
 
-    int win_w = 0, win_h = 0;
-    SDL_GetWindowSize(g_window, &win_w, &win_h);
-    float zoom = g_camera_zoom < 0.05f ? 0.05f : g_camera_zoom;
-    float base_hex_width = g_grid.size * 2.0f;
-    float base_hex_height = sqrtf(3.0f) * g_grid.size;
-    float scaled_hex_width = base_hex_width * zoom;
-    float scaled_hex_height = base_hex_height * zoom;
-    float scaled_hex_size = g_grid.size * zoom;
+static void load_texture_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_load_texture(c->a, c->str);
+}
 
-    if (g_tile_count > 0) {
-        for (int i = 0; i < g_tile_count; ++i) {
-            const HL_TileInstance* tile = &g_tiles[i];
-            float cx, cy;
-            axial_to_pixel_flat(tile->q, tile->r, g_grid.size, &cx, &cy);
-            cx += tile->offset_x;
-            cy += tile->offset_y;
-            world_to_screen(&cx, &cy, win_w, win_h);
-
-            const HL_TextureSlot* terrain_slot = NULL;
-            if (tile->terrain_tex >= 0 && tile->terrain_tex < HL_MAX_TEXTURE_SLOTS) {
-                terrain_slot = &g_textures[tile->terrain_tex];
-            }
-            if (terrain_slot && terrain_slot->texture) {
-                SDL_FRect dest;
-                float terrain_scale = tile->terrain_scale > 0.0f ? tile->terrain_scale : 1.0f;
-                texture_dest_rect(terrain_slot, scaled_hex_width, scaled_hex_height, cx, cy, terrain_scale, &dest);
-                SDL_RenderCopyF(g_renderer, terrain_slot->texture, NULL, &dest);
-            } else {
-                SDL_Color fallback = { 70, 90, 110, 255 };
-                draw_hex_filled(cx, cy, scaled_hex_size, fallback);
-            }
+HEXLIB_API int hl_load_texture(int slot, const char* path) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { slot, 0, 0, NULL, path, 0 };
+        render_call(load_texture_call, &c);
+        return c.result;
+    }
+    if (!g_renderer || !path) return 0;
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
 
-            if (tile->overlay.a > 0) {
-                SDL_Color overlay = { tile->overlay.r, tile->overlay.g, tile->overlay.b, tile->overlay.a };
-                draw_hex_filled(cx, cy, scaled_hex_size, overlay);
-            }
+    loader_cancel(slot);
+    destroy_texture_slot(slot);
+    SDL_Surface* rgba = texture_decode(path);
+    if (!rgba) return 0;
+    return texture_install(slot, rgba);
+}
 
-            const HL_TextureSlot* unit_slot = NULL;
-            if (tile->unit_tex >= 0 && tile->unit_tex < HL_MAX_TEXTURE_SLOTS) {
-                unit_slot = &g_textures[tile->unit_tex];
-            }
-            if (unit_slot && unit_slot->texture) {
-                float unit_scale = tile->unit_scale > 0.0f ? tile->unit_scale : 0.7f;
-                SDL_FRect dest;
-                texture_dest_rect(unit_slot, scaled_hex_width, scaled_hex_height, cx, cy, unit_scale, &dest);
-                SDL_RenderCopyF(g_renderer, unit_slot->texture, NULL, &dest);
-            }
+HEXLIB_API int hl_load_texture_async(int slot, const char* path) {
+    if (!g_renderer || !path) return 0;
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
+    if (!loader_start()) return hl_load_texture(slot, path);
+
+    size_t len = strlen(path);
+    HL_LoadJob* job = (HL_LoadJob*)heap_malloc(sizeof(HL_LoadJob) + len + 1);
+    if (!job) return 0;
+    memcpy(job->path, path, len + 1);
+    job->slot = slot;
+    job->generation = ++g_load_generation[slot];
+    job->surface = NULL;
+    g_load_state[slot] = HL_LOAD_PENDING;
+    loader_submit(job);
+    return 1;
+}
+
+static void texture_ready_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    c->result = hl_texture_ready(c->a);
+}
+
+HEXLIB_API int hl_texture_ready(int slot) {
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return -1;
+    if (g_load_state[slot] == HL_LOAD_PENDING) {
+        if (render_elsewhere()) {
+            HL_RenderCall c = { slot, 0, 0, NULL, NULL, 0 };
+            render_call(texture_ready_call, &c);
+            return c.result;
+        }
+        // Don't wait for the next hl_step if this slot's decode already finished
+        HL_LoadJob* job;
+        while (g_load_state[slot] == HL_LOAD_PENDING && (job = loader_take_done(slot)) != NULL) {
+            texture_install_job(job);
+        }
+        if (g_load_state[slot] == HL_LOAD_PENDING) return 0;
+    }
+    if (g_load_state[slot] == HL_LOAD_FAILED) return -1;
+    return g_textures[slot].texture ? 1 : -1;
+}
+
+HEXLIB_API void hl_set_texture_upload_budget(float ms) {
+    g_upload_budget_ms = ms > 0.0f ? ms : 0.0f;
+}
+
+static void unload_texture_call(void* arg) {
+    hl_unload_texture(((HL_RenderCall*)arg)->a);
+}
+
+HEXLIB_API void hl_unload_texture(int slot) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { slot, 0, 0, NULL, NULL, 0 };
+        render_call(unload_texture_call, &c);
+        return;
+    }
+    if (slot >= 0 && slot < HL_MAX_TEXTURE_SLOTS) loader_cancel(slot);
+    destroy_texture_slot(slot);
+}
+
+static void clear_textures_call(void* arg) {
+    (void)arg;
+    hl_clear_textures();
+}
+
+HEXLIB_API void hl_clear_textures(void) {
+    if (render_elsewhere()) {
+        render_call(clear_textures_call, NULL);
+        return;
+    }
+    for (int i = 0; i < HL_MAX_TEXTURE_SLOTS; ++i) {
+        loader_cancel(i);
+        destroy_texture_slot(i);
+    }
+    atlas_destroy_pages();
+}
+
+HEXLIB_API void hl_set_tiles(const HL_TileInstance* tiles, int count) {
+    if (count <= 0 || !tiles) {
+        instances_clear();
+        map_close();
+        tile_store_clear();
+        return;
+    }
+    HL_TileInstance* dst = hl_map_tiles(count);
+    if (!dst) return;
+    memcpy(dst, tiles, sizeof(HL_TileInstance) * count);
+    HL_STAT_ADD(total_bytes_uploaded, sizeof(HL_TileInstance) * (uint64_t)count);
+    hl_commit_tiles(count);
+}
+
+HEXLIB_API HL_TileInstance* hl_map_tiles(int capacity) {
+    if (capacity < 1) capacity = 1;
+    if (capacity > g_tile_back_cap) {
+        int cap = g_tile_back_cap ? g_tile_back_cap : 256;
+        while (cap < capacity) cap *= 2;
+        HL_TileInstance* back = (HL_TileInstance*)heap_realloc(g_tile_back, sizeof(HL_TileInstance) * cap);
+        if (!back) return NULL;
+        g_tile_back = back;
+        g_tile_back_cap = cap;
+    }
+    return g_tile_back;
+}
+
+HEXLIB_API int hl_commit_tiles(int count) {
+    if (count < 0 || count > g_tile_back_cap) return 0;
+    instances_clear();
+    map_close();
+
+    // Swap halves: the mapped buffer becomes the store, the old store is the next mapping
+    HL_TileInstance* prev = g_tiles;
+    int prev_count = g_tile_count;
+    int prev_cap = g_tile_cap;
+    g_tiles = g_tile_back;
+    g_tile_cap = g_tile_back_cap;
+    g_tile_back = prev;
+    g_tile_back_cap = prev_cap;
+    if (!tile_meta_reserve(g_tile_cap)) {
+        g_tile_count = 0;
+        tile_mark_all_dirty();
+        return 0;
+    }
+    g_tile_count = count;
+
+    // Same coordinates in the same order (the usual case for an embedder that
+    // rewrites its map every frame) keeps the lookup and spatial index and
+    // marks only the tiles whose fields changed
+    int same_layout = prev != NULL && prev_count == count;
+    for (int i = 0; same_layout && i < count; ++i) {
+        same_layout = g_tiles[i].q == prev[i].q && g_tiles[i].r == prev[i].r;
+    }
+    if (same_layout) {
+        for (int i = 0; i < count; ++i) {
+            uint32_t fields = tile_diff(&g_tiles[i], &prev[i]);
+            if (fields) tile_mark_dirty(i, fields);
         }
     } else {
-        // Draw color-only instances (legacy path)
-        for (int i = 0; i < g_instance_count; ++i) {
-            float cx, cy;
-            axial_to_pixel_flat(g_instances[i].q, g_instances[i].r, g_grid.size, &cx, &cy);
-            world_to_screen(&cx, &cy, win_w, win_h);
-            SDL_Color c = { g_instances[i].color.r, g_instances[i].color.g, g_instances[i].color.b, g_instances[i].color.a };
-            draw_hex_filled(cx, cy, scaled_hex_size, c);
+        tile_lookup_rebuild();
+        tile_mark_all_dirty();
+    }
+
+    // Track how far any tile can reach beyond its hex so culling stays conservative
+    g_tile_max_scale = 1.0f;
+    g_tile_max_offset = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        tile_track_extent(&g_tiles[i]);
+    }
+    return 1;
+}
+
+HEXLIB_API int hl_update_tiles(const HL_TileInstance* patches, int count, uint32_t field_mask) {
+    if (!patches || count <= 0) return 0;
+    instances_clear();
+    HL_STAT_ADD(total_bytes_uploaded, sizeof(HL_TileInstance) * (uint64_t)count);
+    int applied = 0;
+    for (int k = 0; k < count; ++k) {
+        const HL_TileInstance* p = &patches[k];
+        uint32_t fields = field_mask;
+        map_touch(p->q, p->r);
+        int i = tile_lookup_find(p->q, p->r);
+        if (i < 0) {
+            // Unknown coordinate: append a blank tile and apply the masked fields to it
+            if (!tile_reserve(g_tile_count + 1) || !tile_lookup_reserve(g_tile_lookup_used + 1)) break;
+            i = g_tile_count++;
+            HL_TileInstance* t = &g_tiles[i];
+            memset(t, 0, sizeof(*t));
+            t->q = p->q;
+            t->r = p->r;
+            t->terrain_tex = -1;
+            t->unit_tex = -1;
+            g_tile_dirty[i] = 0;
+            tile_lookup_put(g_tile_lookup, g_tile_lookup_cap, p->q, p->r, i, &g_tile_lookup_used);
+            tile_index_add(i);
+            fields = HL_TILE_ALL;
+        }
+        HL_TileInstance* t = &g_tiles[i];
+        if (field_mask & HL_TILE_TERRAIN) {
+            t->terrain_tex = p->terrain_tex;
+            t->terrain_scale = p->terrain_scale;
+        }
+        if (field_mask & HL_TILE_UNIT) {
+            t->unit_tex = p->unit_tex;
+            t->unit_scale = p->unit_scale;
+        }
+        if (field_mask & HL_TILE_OVERLAY) {
+            t->overlay = p->overlay;
+        }
+        if (field_mask & HL_TILE_OFFSET) {
+            t->offset_x = p->offset_x;
+            t->offset_y = p->offset_y;
         }
+        tile_track_extent(t);
+        tile_mark_dirty(i, fields);
+        applied++;
     }
+    return applied;
+}
 
-    if (g_label_count > 0) {
-        float label_scale = fmaxf(3.0f, 4.5f * zoom);
-        for (int i = 0; i < g_label_count; ++i) {
-            float cx, cy;
-            axial_to_pixel_flat(g_labels[i].q, g_labels[i].r, g_grid.size, &cx, &cy);
-            world_to_screen(&cx, &cy, win_w, win_h);
-            draw_label(g_renderer, cx, cy, g_labels[i].text, label_scale);
+// Swap-remove tile `i`: the last tile takes over the freed slot. The index,
+// columns and minimap are patched in place and only the removed tile's chunk
+// is redrawn (if `redraw`); the moved tile keeps its column, so its chunk is
+// unchanged.
+static void tile_remove(int i, int redraw) {
+    int32_t q = g_tiles[i].q, r = g_tiles[i].r;
+    tile_lookup_remove(g_tile_lookup, g_tile_lookup_cap, q, r, &g_tile_lookup_used);
+    tile_dirty_drop(i);
+    int bucket = tile_index_remove(i);
+    if (bucket >= 0) {
+        minimap_clear_texel(bucket, q, r);
+        if (g_tile_index.buckets[bucket].count == 0) spatial_remove_bucket(&g_tile_index, bucket, minimap_bucket_moved);
+    }
+    if (redraw) {
+        chunk_cache_invalidate(q, r);
+        scene_damage_chunk(chunk_coord(q), chunk_coord(r));
+    }
+    int last = g_tile_count - 1;
+    if (i != last) {
+        g_tiles[i] = g_tiles[last];
+        if (tile_lookup_find(g_tiles[i].q, g_tiles[i].r) == last) {
+            tile_lookup_put(g_tile_lookup, g_tile_lookup_cap, g_tiles[i].q, g_tiles[i].r, i, &g_tile_lookup_used);
         }
+        tile_dirty_move(last, i);
+        tile_index_renumber(last, i);
     }
+    g_tile_count--;
+}
 
-    SDL_RenderPresent(g_renderer);
+HEXLIB_API int hl_remove_tiles(const int32_t* coords, int count) {
+    if (!coords || count <= 0) return 0;
+    HL_STAT_ADD(total_bytes_uploaded, sizeof(int32_t) * 2 * (uint64_t)count);
+    int removed = 0;
+    for (int k = 0; k < count; ++k) {
+        int32_t q = coords[k * 2];
+        int32_t r = coords[k * 2 + 1];
+        map_touch(q, r);
+        int i = tile_lookup_find(q, r);
+        if (i < 0) continue;
+        tile_remove(i, 1);
+        removed++;
+    }
+    return removed;
 }
 
-HEXLIB_API int hl_poll_event(int* out_q, int* out_r) {
-    SDL_Event e;
-    while (SDL_PollEvent(&e)) {
-        switch (e.type) {
-            case SDL_QUIT: return 1;
-            case SDL_MOUSEBUTTONDOWN: {
-                int mx = e.button.x, my = e.button.y;
-                float fx = (float)mx;
-                float fy = (float)my;
-                screen_to_world(&fx, &fy);
-                int q=0, r=0;
-                pixel_to_axial_flat(fx, fy, g_grid.size, &q, &r);
-                if (out_q) *out_q = q;
-                if (out_r) *out_r = r;
-                if (e.button.button == SDL_BUTTON_RIGHT) {
-                    return 4;
-                }
-                if (e.button.button == SDL_BUTTON_LEFT) {
-                    return 2;
+// Drop unedited map chunks that the last map_stream pass did not reach,
+// least recently seen first, until HL_MAP_RESIDENT_CHUNKS fit again. They are
+// off screen, so nothing is redrawn.
+static void map_evict(void) {
+    if (!g_map.data || g_map.unedited <= HL_MAP_RESIDENT_CHUNKS) return;
+    uint64_t* keys = (uint64_t*)heap_malloc(sizeof(uint64_t) * g_map.unedited);
+    if (!keys) return;
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < g_map.chunk_count; ++k) {
+        if (g_map.resident[k] == HL_CHUNK_LOADED && g_map.seen[k] != g_map.pass) {
+            keys[n++] = (uint64_t)g_map.seen[k] << 32 | k;
+        }
+    }
+    qsort(keys, n, sizeof(uint64_t), map_key_compare);
+    uint32_t evict = g_map.unedited - HL_MAP_RESIDENT_CHUNKS * 3 / 4;
+    if (evict > HL_MAP_EVICTS_PER_FRAME) evict = HL_MAP_EVICTS_PER_FRAME;
+    if (evict > n) evict = n;
+    for (uint32_t e = 0; e < evict; ++e) {
+        uint32_t k = (uint32_t)keys[e];
+        const HL_MapChunk* c = &g_map.chunks[k];
+        for (uint32_t j = 0; j < c->count; ++j) {
+            uint8_t cell = g_map.tiles[c->first + j].cell;
+            int i = tile_lookup_find(c->cq * HL_CHUNK_SIZE + cell % HL_CHUNK_SIZE,
+                                     c->cr * HL_CHUNK_SIZE + (cell / HL_CHUNK_SIZE) % HL_CHUNK_SIZE);
+            if (i >= 0) tile_remove(i, 0);
+        }
+        g_map.resident[k] = HL_CHUNK_ABSENT;
+        g_map.unedited--;
+    }
+    free(keys);
+}
+
+static void clear_tiles_call(void* arg) {
+    (void)arg;
+    hl_clear_tiles();
+}
+
+HEXLIB_API void hl_clear_tiles(void) {
+    if (render_elsewhere()) {
+        render_call(clear_tiles_call, NULL);
+        return;
+    }
+    map_close();
+    tile_store_free();
+    tile_columns_free();
+    minimap_free();
+    labels_clear();
+    anim_free();
+}
+
+HEXLIB_API int hl_load_map(const char* path) {
+    if (!g_renderer || !path) return 0;
+    HL_Map map;
+    if (!map_open(&map, path)) return 0;
+    map.resident = (uint8_t*)heap_calloc(map.chunk_count ? map.chunk_count : 1, 1);
+    map.seen = (uint32_t*)heap_calloc(map.chunk_count ? map.chunk_count : 1, sizeof(uint32_t));
+    if (!map.resident || !map.seen) {
+        map_unmap(&map);
+        return 0;
+    }
+    instances_clear();
+    map_close();
+    tile_store_clear();
+    g_map = map;
+    g_tile_max_scale = 1.0f;
+    g_tile_max_offset = 0.0f;
+    g_tile_index.dirty = 1;
+    return 1;
+}
+
+HEXLIB_API int hl_save_map(const char* path) {
+    if (!path) return 0;
+    // A streamed map is saved whole. Let go of its file afterwards, as it
+    // may be the one being overwritten.
+    for (uint32_t k = 0; k < g_map.chunk_count; ++k) {
+        map_load_chunk(k);
+        if (g_map.resident[k] == HL_CHUNK_ABSENT) return 0;
+    }
+    map_close();
+
+    // Sort by (cq, cr, cell): chunk coords biased into 29 bits each
+    int count = g_tile_count;
+    uint64_t* keys = (uint64_t*)heap_malloc(sizeof(uint64_t) * (size_t)(count > 0 ? count : 1));
+    if (!keys) return 0;
+    const uint64_t bias = (uint64_t)1 << 28;
+    for (int i = 0; i < count; ++i) {
+        int32_t cq = chunk_coord(g_tiles[i].q), cr = chunk_coord(g_tiles[i].r);
+        uint32_t cell = (uint32_t)(g_tiles[i].q - cq * HL_CHUNK_SIZE) +
+                        (uint32_t)(g_tiles[i].r - cr * HL_CHUNK_SIZE) * HL_CHUNK_SIZE;
+        keys[i] = ((uint64_t)((int64_t)cq + bias) << 35) | ((uint64_t)((int64_t)cr + bias) << 6) | cell;
+    }
+    qsort(keys, (size_t)count, sizeof(uint64_t), map_key_compare);
+    uint32_t chunk_count = 0;
+    for (int i = 0; i < count; ++i) {
+        if (i == 0 || (keys[i] >> 6) != (keys[i - 1] >> 6)) chunk_count++;
+    }
+
+    HL_MapHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, HL_MAP_MAGIC, 8);
+    h.version = HL_MAP_VERSION;
+    h.byte_order = HL_MAP_BYTE_ORDER;
+    h.header_size = sizeof(HL_MapHeader);
+    h.chunk_size = HL_CHUNK_SIZE;
+    h.chunk_count = chunk_count;
+    h.tile_count = (uint32_t)count;
+    h.chunks_offset = sizeof(HL_MapHeader);
+    h.tiles_offset = h.chunks_offset + (uint64_t)chunk_count * sizeof(HL_MapChunk);
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        SDL_Log("Map '%s' could not be created", path);
+        free(keys);
+        return 0;
+    }
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (int i = 0; ok && i < count;) {
+        int end = i + 1;
+        while (end < count && (keys[end] >> 6) == (keys[i] >> 6)) end++;
+        HL_MapChunk c;
+        c.cq = (int32_t)((int64_t)(keys[i] >> 35) - (int64_t)bias);
+        c.cr = (int32_t)((int64_t)((keys[i] >> 6) & ((1u << 29) - 1)) - (int64_t)bias);
+        c.first = (uint32_t)i;
+        c.count = (uint32_t)(end - i);
+        ok = fwrite(&c, sizeof(c), 1, f) == 1;
+        i = end;
+    }
+    HL_MapTile buf[256];
+    int buffered = 0;
+    for (int i = 0; ok && i < count; ++i) {
+        int32_t cq = (int32_t)((int64_t)(keys[i] >> 35) - (int64_t)bias);
+        int32_t cr = (int32_t)((int64_t)((keys[i] >> 6) & ((1u << 29) - 1)) - (int64_t)bias);
+        uint32_t cell = (uint32_t)(keys[i] & 63);
+        const HL_TileInstance* t = &g_tiles[tile_lookup_find(cq * HL_CHUNK_SIZE + (int32_t)(cell % HL_CHUNK_SIZE),
+                                                             cr * HL_CHUNK_SIZE + (int32_t)(cell / HL_CHUNK_SIZE))];
+        HL_MapTile* m = &buf[buffered++];
+        m->cell = (uint8_t)cell;
+        m->terrain_tex = (int8_t)(t->terrain_tex >= 0 && t->terrain_tex < HL_MAX_TEXTURE_SLOTS ? t->terrain_tex : -1);
+        m->unit_tex = (int8_t)(t->unit_tex >= 0 && t->unit_tex < HL_MAX_TEXTURE_SLOTS ? t->unit_tex : -1);
+        m->reserved = 0;
+        m->overlay = t->overlay;
+        m->terrain_scale = t->terrain_scale;
+        m->unit_scale = t->unit_scale;
+        if (buffered == 256 || i == count - 1) {
+            ok = fwrite(buf, sizeof(HL_MapTile), (size_t)buffered, f) == (size_t)buffered;
+            buffered = 0;
+        }
+    }
+    if (fclose(f) != 0) ok = 0;
+    free(keys);
+    if (!ok) SDL_Log("Map '%s' could not be written", path);
+    return ok;
+}
+
+HEXLIB_API void hl_set_debug_labels(const HL_DebugLabel* labels, int count) {
+    labels_clear();
+    if (!labels || count <= 0 || !label_reserve(count)) return;
+    memcpy(g_labels, labels, sizeof(HL_DebugLabel) * count);
+    HL_STAT_ADD(total_bytes_uploaded, sizeof(HL_DebugLabel) * (uint64_t)count);
+    g_label_count = count;
+    g_label_index.dirty = 1;
+}
+
+HEXLIB_API int hl_query_texture(int slot, int* out_w, int* out_h) {
+    if (slot < 0 || slot >= HL_MAX_TEXTURE_SLOTS) return 0;
+    if (!g_textures[slot].texture) return 0;
+    if (out_w) *out_w = g_textures[slot].w;
+    if (out_h) *out_h = g_textures[slot].h;
+    return 1;
+}
+
+HEXLIB_API void hl_set_clear_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    if (g_clear.r == r && g_clear.g == g && g_clear.b == b && g_clear.a == a) return;
+    g_clear.r = r; g_clear.g = g; g_clear.b = b; g_clear.a = a;
+    scene_damage_all();
+}
+
+// --- Frame damage ---
+// What frame_build works out once per frame for its draw passes
+typedef struct {
+    int   win_w, win_h;
+    int   lod;
+    int   chunks;         // visible chunks left by chunk_cache_prepare
+    float zoom;
+    float reach;          // world pixels a tile can cover past its center
+    float max_offset;
+    float hex_w, hex_h;   // scaled hex bounds
+    float hex_size;       // scaled hex radius
+} HL_FrameView;
+
+static SDL_Rect g_damage_rects[HL_MAX_DAMAGE_RECTS];
+static float    g_damage_reach = 0.0f;   // reach of the last frame drawn
+static uint32_t g_damage_fog = 0;        // g_fog_version of the last frame drawn
+
+// Back buffer matching the output, or NULL to draw straight to it (tracking
+// off, no render-target support, or creation failed)
+static SDL_Texture* backbuffer_ensure(int w, int h) {
+    if (!g_damage_tracking || w <= 0 || h <= 0) {
+        backbuffer_free();
+        return NULL;
+    }
+    if (w == g_backbuffer_w && h == g_backbuffer_h) return g_backbuffer;
+    backbuffer_free();
+    g_backbuffer_w = w;
+    g_backbuffer_h = h;
+    scene_damage_all();
+    if (!SDL_RenderTargetSupported(g_renderer)) return NULL;
+    g_backbuffer = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!g_backbuffer) {
+        SDL_Log("Back buffer %dx%d failed: %s", w, h, SDL_GetError());
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(g_backbuffer, SDL_BLENDMODE_NONE);
+    return g_backbuffer;
+}
+
+static int rects_touch(const SDL_Rect* a, const SDL_Rect* b) {
+    return a->x <= b->x + b->w && b->x <= a->x + a->w && a->y <= b->y + b->h && b->y <= a->y + a->h;
+}
+
+// Add `r` to the first `n` damage rects, merged with every rect it touches;
+// once HL_MAX_DAMAGE_RECTS are taken, merged into the one it grows least.
+// Returns the new count.
+static int damage_add_rect(SDL_Rect r, int n) {
+    for (;;) {
+        int hit = -1;
+        for (int k = 0; k < n && hit < 0; ++k) {
+            if (rects_touch(&r, &g_damage_rects[k])) hit = k;
+        }
+        if (hit < 0 && n == HL_MAX_DAMAGE_RECTS) {
+            long long best = 0;
+            for (int k = 0; k < n; ++k) {
+                SDL_Rect u;
+                SDL_UnionRect(&r, &g_damage_rects[k], &u);
+                long long growth = (long long)u.w * u.h - (long long)g_damage_rects[k].w * g_damage_rects[k].h;
+                if (hit < 0 || growth < best) {
+                    hit = k;
+                    best = growth;
                 }
-                break;
             }
-            case SDL_MOUSEMOTION: {
-                int mx = e.motion.x, my = e.motion.y;
-                float fx = (float)mx;
-                float fy = (float)my;
-                screen_to_world(&fx, &fy);
-                int q=0, r=0;
-                pixel_to_axial_flat(fx, fy, g_grid.size, &q, &r);
-                if (out_q) *out_q = q;
-                if (out_r) *out_r = r;
-                return 3;
+        }
+        if (hit < 0) break;
+        SDL_UnionRect(&r, &g_damage_rects[hit], &r);
+        g_damage_rects[hit] = g_damage_rects[--n];
+    }
+    g_damage_rects[n++] = r;
+    return n;
+}
+
+// Screen rectangles covering the damaged chunks, each grown by `pad` pixels,
+// in g_damage_rects. Returns their count (0: nothing on screen changed), or
+// -1 when they cover so much of the screen that a full redraw is cheaper.
+static int frame_damage_rects(int win_w, int win_h, float pad) {
+    HL_Projection p;
+    projection_setup(&p, win_w, win_h, 0.0f);
+    int n = 0;
+    for (int k = 0; k < g_damage_chunk_count; ++k) {
+        float box[4];
+        chunk_screen_box(&p, g_damage_chunks[2 * k], g_damage_chunks[2 * k + 1], pad, box);
+        int x0 = box[0] > 0.0f ? (int)box[0] : 0;
+        int y0 = box[1] > 0.0f ? (int)box[1] : 0;
+        int x1 = box[2] < (float)win_w ? (int)ceilf(box[2]) : win_w;
+        int y1 = box[3] < (float)win_h ? (int)ceilf(box[3]) : win_h;
+        if (x1 <= x0 || y1 <= y0) continue;
+        SDL_Rect r = { x0, y0, x1 - x0, y1 - y0 };
+        n = damage_add_rect(r, n);
+    }
+    long long area = 0;
+    for (int k = 0; k < n; ++k) area += (long long)g_damage_rects[k].w * g_damage_rects[k].h;
+    return area * 2 >= (long long)win_w * win_h ? -1 : n;
+}
+
+// Draw the tile layers (or the legacy instances). With a `clip` rectangle
+// only what can reach it is drawn. Returns how many items there were to
+// draw, for hexes_culled.
+static uint32_t frame_draw_tiles(const HL_FrameView* v, const SDL_Rect* clip) {
+    int win_w = v->win_w, win_h = v->win_h;
+    float zoom = v->zoom;
+    if (g_tile_count > 0) {
+        // Tiles are drawn as terrain (fallback hexes, terrain sprites),
+        // overlays, then unit sprites
+        HL_Projection proj;
+        projection_setup(&proj, win_w, win_h, v->reach * zoom);
+        projection_clip(&proj, clip, v->reach * zoom);
+        int chunks, drawn;
+        if (v->lod != HL_LOD_FULL) {
+            // Flat tiers ignore sprite overhang; offsets still move the hexes
+            float flat_reach = g_grid.size + v->max_offset;
+            chunks = spatial_query_chunks(&g_tile_index, win_w, win_h, flat_reach);
+            chunks = chunks_clip(chunks, &proj, clip, flat_reach * zoom);
+            drawn = v->lod == HL_LOD_MINIMAP ? minimap_draw(&proj, chunks) : -1;
+            if (drawn < 0) {
+                projection_setup(&proj, win_w, win_h, flat_reach * zoom);
+                projection_clip(&proj, clip, flat_reach * zoom);
+                drawn = project_chunks(&proj, chunks);
+                draw_tile_flat(g_visible, g_screen_pos, drawn);
             }
-            case SDL_KEYDOWN: {
-                if (e.key.repeat) break;
-                if (out_q) *out_q = (int)e.key.keysym.sym;
-                if (out_r) *out_r = 0;
-                return 5;
+            HL_STAT_ADD(hexes_drawn, (uint32_t)drawn);
+        } else if (g_retained) {
+            // Label passes reuse g_visible_chunks, so later passes query again
+            chunks = clip ? chunks_clip(spatial_query_chunks(&g_tile_index, win_w, win_h, v->reach), &proj, clip, v->reach * zoom)
+                          : v->chunks;
+            drawn = chunk_cache_draw(chunks, &proj, win_w, win_h, zoom);
+            HL_STAT_ADD(hexes_drawn, (uint32_t)drawn);
+            draw_tiles(g_visible, g_screen_pos, drawn, HL_LAYER_TERRAIN | HL_LAYER_OVERLAYS, v->hex_w, v->hex_h);
+            // Units and fog are never cached: project every visible chunk
+            // again (the unit layer skips tiles without a unit)
+            drawn = project_chunks(&proj, chunks);
+            draw_tiles(g_visible, g_screen_pos, drawn, HL_LAYER_UNITS | HL_LAYER_FOG, v->hex_w, v->hex_h);
+        } else {
+            chunks = spatial_query_chunks(&g_tile_index, win_w, win_h, v->reach);
+            chunks = chunks_clip(chunks, &proj, clip, v->reach * zoom);
+            drawn = project_chunks(&proj, chunks);
+            HL_STAT_ADD(hexes_drawn, (uint32_t)drawn);
+            draw_tiles(g_visible, g_screen_pos, drawn, HL_LAYER_ALL, v->hex_w, v->hex_h);
+        }
+        return (uint32_t)g_tile_count;
+    }
+    if (!(g_layers & HL_LAYER_TERRAIN)) return 0;
+    // Draw color-only instances (legacy path)
+    int visible = spatial_query(&g_instance_index, win_w, win_h, 0.0f);
+    float cull = v->hex_size;
+    float x0 = clip ? (float)clip->x : 0.0f, y0 = clip ? (float)clip->y : 0.0f;
+    float x1 = clip ? (float)(clip->x + clip->w) : (float)win_w, y1 = clip ? (float)(clip->y + clip->h) : (float)win_h;
+    for (int k = 0; k < visible; ++k) {
+        const HL_HexInstance* inst = &g_instances[g_visible[k]];
+        float cx, cy;
+        axial_to_pixel(inst->q, inst->r, g_grid.size, &cx, &cy);
+        world_to_screen(&cx, &cy, win_w, win_h);
+        if (cx < x0 - cull || cy < y0 - cull || cx > x1 + cull || cy > y1 + cull) continue;
+        SDL_Color c = { inst->color.r, inst->color.g, inst->color.b, inst->color.a };
+        if (v->lod == HL_LOD_FULL) batch_hex(cx, cy, c);
+        else batch_hex_fill(cx, cy, c);
+        HL_STAT_ADD(hexes_drawn, 1);
+    }
+    batch_flush();
+    return (uint32_t)g_instance_count;
+}
+
+static void frame_draw_labels(const HL_FrameView* v, const SDL_Rect* clip) {
+    if (g_label_count <= 0 || v->lod != HL_LOD_FULL || !(g_layers & HL_LAYER_LABELS)) return;
+    int win_w = v->win_w, win_h = v->win_h;
+    float label_scale = fmaxf(3.0f, 4.5f * v->zoom);
+    // Labels are sized in screen pixels: widest is 15 glyphs of 4 cells
+    float half_w = 15.0f * 4.0f * label_scale * 0.5f;
+    float x0 = clip ? (float)clip->x : 0.0f, y0 = clip ? (float)clip->y : 0.0f;
+    float x1 = clip ? (float)(clip->x + clip->w) : (float)win_w, y1 = clip ? (float)(clip->y + clip->h) : (float)win_h;
+    int visible = spatial_query(&g_label_index, win_w, win_h, half_w / v->zoom);
+    for (int k = 0; k < visible; ++k) {
+        const HL_DebugLabel* label = &g_labels[g_visible[k]];
+        float cx, cy;
+        axial_to_pixel(label->q, label->r, g_grid.size, &cx, &cy);
+        world_to_screen(&cx, &cy, win_w, win_h);
+        if (cx < x0 - half_w || cy < y0 - half_w || cx > x1 + half_w || cy > y1 + half_w) continue;
+        draw_label(g_renderer, cx, cy, label->text, label_scale);
+        HL_STAT_ADD(labels_drawn, 1);
+    }
+    batch_flush();
+}
+
+// Everything in a frame up to the present. Fills in the stats timestamps.
+// Returns 0 if nothing changed since the last frame drawn, in which case
+// nothing was drawn and there is nothing to present.
+static int frame_build(float dt_seconds, Uint64* t_start_out, Uint64* t_tiles_out, Uint64* t_labels_out) {
+    g_frame_index++;
+    Uint64 t_start = HL_STAT_NOW();
+    stats_begin_frame(t_start);
+    texture_uploads(g_upload_budget_ms);
+    anim_advance(dt_seconds);
+
+    HL_FrameView v;
+    hl_get_output_size(&v.win_w, &v.win_h);
+    int win_w = v.win_w, win_h = v.win_h;
+    float zoom = g_camera_zoom < 0.05f ? 0.05f : g_camera_zoom;
+    hex_bounds(g_grid.size, &v.hex_w, &v.hex_h);
+    v.zoom = zoom;
+    v.hex_w *= zoom;
+    v.hex_h *= zoom;
+    v.hex_size = g_grid.size * zoom;
+
+    Uint64 t_tiles = HL_STAT_NOW();
+    if (g_map.data) {
+        // Copy in the map chunks on screen plus one chunk of lookahead
+        float ahead = g_grid.size * (g_tile_max_scale * max_texture_aspect() + HL_CHUNK_SIZE) + g_tile_max_offset + g_anim_reach;
+        map_stream(win_w, win_h, ahead);
+        map_evict();
+    }
+    if (g_tile_index.dirty || g_instance_index.dirty || g_label_index.dirty || g_fog_version != g_damage_fog) scene_damage_all();
+    // In-place index edits leave gaps in the chunk runs; repack once they outnumber the tiles
+    int repack = g_tile_index.item_count > 2 * g_tile_count + HL_CHUNK_SIZE * HL_CHUNK_SIZE * 16;
+    if (g_tile_index.dirty || repack) {
+        spatial_build(&g_tile_index, g_tiles, sizeof(HL_TileInstance), g_tile_count);
+        tile_columns_build();
+        g_minimap_stale = 1;
+    } else {
+        tile_columns_sync();
+    }
+    if (g_instance_index.dirty) spatial_build(&g_instance_index, g_instances, sizeof(HL_HexInstance), g_instance_count);
+    if (g_label_index.dirty) spatial_build(&g_label_index, g_labels, sizeof(HL_DebugLabel), g_label_count);
+
+    // World-space reach of a tile beyond its center: sprite overhang plus offsets
+    float overhang = g_grid.size * g_tile_max_scale * max_texture_aspect();
+    v.max_offset = g_tile_max_offset + g_anim_reach;
+    v.reach = overhang + v.max_offset;
+    v.lod = lod_tier(v.hex_size);
+    v.chunks = 0;
+    if (g_anim_count && g_tile_count > 0 && v.lod == HL_LOD_FULL) {
+        anim_apply(spatial_query_chunks(&g_tile_index, win_w, win_h, v.reach), dt_seconds > 0.0f);
+    }
+    if (g_retained && g_tile_count > 0 && v.lod == HL_LOD_FULL) v.chunks = chunk_cache_prepare(win_w, win_h, v.reach, overhang, zoom);
+
+    // Which screen rectangles to redraw: one full pass, some clipped passes
+    // into the back buffer, or none at all
+    SDL_Texture* target = backbuffer_ensure(win_w, win_h);
+    int rects = -1;
+    if (g_damage_tracking && g_scene_gen == g_scene_drawn) {
+        rects = 0;
+    } else if (g_damage_tracking && !g_damage_all) {
+        // Anything that moved may have been drawn up to the old reach away
+        float pad = (fmaxf(v.reach, g_damage_reach) + g_grid.size) * zoom + 1.0f;
+        rects = frame_damage_rects(win_w, win_h, pad);
+        if (rects > 0 && !(target && g_backbuffer_valid)) rects = -1;
+    }
+    if (rects == 0) {
+        if (v.lod != HL_LOD_MINIMAP) minimap_note_changes();
+        tile_dirty_reset();
+        scene_damage_clear();
+        HL_STAT_ADD(skipped_frames, 1);
+        *t_start_out = t_start;
+        *t_tiles_out = *t_labels_out = HL_STAT_NOW();
+        return 0;
+    }
+
+    if (target) SDL_SetRenderTarget(g_renderer, target);
+    update_corner_offsets(v.hex_size);
+    SDL_SetRenderDrawColor(g_renderer, g_clear.r, g_clear.g, g_clear.b, g_clear.a);
+    uint32_t items;
+    Uint64 t_labels;
+    if (rects < 0) {
+        SDL_RenderClear(g_renderer);
+        items = frame_draw_tiles(&v, NULL);
+        t_labels = HL_STAT_NOW();
+        frame_draw_labels(&v, NULL);
+        HL_STAT_ADD(damage_rects, 1);
+        HL_STAT_ADD(redrawn_pixels, (uint32_t)win_w * (uint32_t)win_h);
+    } else {
+        // RenderClear ignores the clip rectangle: fill each region instead.
+        // Regions never overlap, so the labels can follow in a second round.
+        items = 0;
+        for (int k = 0; k < rects; ++k) {
+            const SDL_Rect* r = &g_damage_rects[k];
+            SDL_RenderSetClipRect(g_renderer, r);
+            SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_NONE);
+            SDL_RenderFillRect(g_renderer, r);
+            SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+            items = frame_draw_tiles(&v, r);
+            HL_STAT_ADD(redrawn_pixels, (uint32_t)r->w * (uint32_t)r->h);
+        }
+        t_labels = HL_STAT_NOW();
+        for (int k = 0; k < rects; ++k) {
+            SDL_RenderSetClipRect(g_renderer, &g_damage_rects[k]);
+            frame_draw_labels(&v, &g_damage_rects[k]);
+        }
+        SDL_RenderSetClipRect(g_renderer, NULL);
+        HL_STAT_ADD(damage_rects, (uint32_t)rects);
+    }
+#if HEXLIB_STATS
+    // Clipped passes may each draw a tile the others drew too
+    if (items > g_stats.hexes_drawn) g_stats.hexes_culled += items - g_stats.hexes_drawn;
+#else
+    (void)items;
+#endif
+    if (target) {
+        SDL_SetRenderTarget(g_renderer, NULL);
+        SDL_RenderCopy(g_renderer, target, NULL, NULL);
+        g_backbuffer_valid = 1;
+    }
+
+    if (v.lod != HL_LOD_MINIMAP) minimap_note_changes();
+    tile_dirty_reset();
+    scene_damage_clear();
+    g_damage_reach = v.reach;
+    g_damage_fog = g_fog_version;
+    *t_start_out = t_start;
+    *t_tiles_out = t_tiles;
+    *t_labels_out = t_labels;
+    return 1;
+}
+
+static void step_call(void* arg) {
+    HL_RenderCall* c = (HL_RenderCall*)arg;
+    Uint64 t_start, t_tiles, t_labels;
+    c->result = frame_build(*(const float*)c->p, &t_start, &t_tiles, &t_labels);
+    Uint64 t_end = HL_STAT_NOW();
+    stats_end_frame(t_start, t_tiles, t_labels, t_end, t_end);
+#if HEXLIB_STATS
+    // The present runs after the caller is released: report the previous one
+    g_stats.present_ms = stats_ms(0, g_render_present_ticks);
+#endif
+    g_render_present = c->result;
+}
+
+HEXLIB_API int hl_step(float dt_seconds) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { 0, 0, 0, &dt_seconds, NULL, 0 };
+        render_call(step_call, &c);
+        return c.result;
+    }
+    Uint64 t_start, t_tiles, t_labels;
+    int drawn = frame_build(dt_seconds, &t_start, &t_tiles, &t_labels);
+    Uint64 t_present = HL_STAT_NOW();
+    if (drawn) SDL_RenderPresent(g_renderer);
+    stats_end_frame(t_start, t_tiles, t_labels, t_present, HL_STAT_NOW());
+    return drawn;
+}
+
+static void damage_tracking_call(void* arg) {
+    hl_set_damage_tracking(((HL_RenderCall*)arg)->a);
+}
+
+HEXLIB_API void hl_set_damage_tracking(int enabled) {
+    if (render_elsewhere()) {
+        HL_RenderCall c = { enabled, 0, 0, NULL, NULL, 0 };
+        render_call(damage_tracking_call, &c);
+        return;
+    }
+    g_damage_tracking = enabled ? 1 : 0;
+    if (!g_damage_tracking) backbuffer_free();
+    scene_damage_all();
+}
+
+HEXLIB_API void hl_get_frame_stats(HL_FrameStats* out) {
+    if (out) *out = g_stats;  // all zeros when built with HEXLIB_STATS=0
+}
+
+// --- Input ---
+static int32_t g_pointer_q = 0, g_pointer_r = 0;  // hex of the last reported mouse event
+static int     g_pointer_valid = 0;
+
+static void device_reset_call(void* arg) {
+    (void)arg;
+    for (int i = 0; i < g_chunk_cache_cap; ++i) {
+        if (g_chunk_cache[i].used) chunk_cache_drop_texture(&g_chunk_cache[i]);
+    }
+    minimap_free();
+    backbuffer_free();
+    scene_damage_all();
+}
+
+// Events hexlib consumes itself: window resizes and exposes, and lost render
+// targets
+static void event_handle_internal(const SDL_Event* e) {
+    switch (e->type) {
+        case SDL_WINDOWEVENT:
+            if (e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED && g_window) {
+                g_output_w = e->window.data1;
+                g_output_h = e->window.data2;
             }
-            case SDL_KEYUP: {
-                if (out_q) *out_q = (int)e.key.keysym.sym;
-                if (out_r) *out_r = 0;
-                return 6;
+            // The window system may have dropped what was on screen
+            if (e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED || e->window.event == SDL_WINDOWEVENT_EXPOSED ||
+                e->window.event == SDL_WINDOWEVENT_SHOWN || e->window.event == SDL_WINDOWEVENT_RESTORED) {
+                scene_damage_all();
             }
-            default: break;
+            break;
+        case SDL_RENDER_TARGETS_RESET:
+            // Target textures lost their contents: re-render cached chunks
+            // and the whole back buffer
+            chunk_cache_invalidate_all();
+            g_backbuffer_valid = 0;
+            scene_damage_all();
+            break;
+        case SDL_RENDER_DEVICE_RESET:
+            render_call(device_reset_call, NULL);
+            break;
+        default: break;
+    }
+}
+
+static void event_pointer(HL_Event* out, int x, int y) {
+    float fx = (float)x;
+    float fy = (float)y;
+    screen_to_world(&fx, &fy);
+    int q = 0, r = 0;
+    pixel_to_axial(fx, fy, g_grid.size, &q, &r);
+    out->x = x;
+    out->y = y;
+    out->q = q;
+    out->r = r;
+    out->mod = (uint16_t)SDL_GetModState();
+    if (!g_pointer_valid || q != g_pointer_q || r != g_pointer_r) out->flags |= HL_EVENT_HEX_CHANGED;
+    g_pointer_q = q;
+    g_pointer_r = r;
+    g_pointer_valid = 1;
+}
+
+// Next queued event. With a render thread the queue is pumped there, so only
+// take what has already arrived.
+static int event_next(SDL_Event* e) {
+    if (g_render_thread) return SDL_PeepEvents(e, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0;
+    return SDL_PollEvent(e);
+}
+
+// Translate one SDL event; returns 0 for events the embedder never sees
+static int event_translate(const SDL_Event* e, HL_Event* out) {
+    memset(out, 0, sizeof(*out));
+    switch (e->type) {
+        case SDL_QUIT:
+            out->type = HL_EVENT_QUIT;
+            return 1;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            if (e->type == SDL_MOUSEBUTTONUP) out->type = HL_EVENT_MOUSE_UP;
+            else if (e->button.button == SDL_BUTTON_LEFT) out->type = HL_EVENT_LEFT_DOWN;
+            else if (e->button.button == SDL_BUTTON_RIGHT) out->type = HL_EVENT_RIGHT_DOWN;
+            else return 0;
+            out->key = e->button.button;
+            event_pointer(out, e->button.x, e->button.y);
+            return 1;
+        case SDL_MOUSEMOTION:
+            out->type = HL_EVENT_MOUSE_MOVE;
+            event_pointer(out, e->motion.x, e->motion.y);
+            return 1;
+        case SDL_MOUSEWHEEL: {
+            int mx = 0, my = 0;
+            SDL_GetMouseState(&mx, &my);
+            out->type = HL_EVENT_WHEEL;
+            event_pointer(out, mx, my);
+            float dir = e->wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -1.0f : 1.0f;
+            out->wheel_x = dir * e->wheel.preciseX;
+            out->wheel_y = dir * e->wheel.preciseY;
+            return 1;
+        }
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            if (e->type == SDL_KEYDOWN && e->key.repeat) return 0;
+            out->type = e->type == SDL_KEYDOWN ? HL_EVENT_KEY_DOWN : HL_EVENT_KEY_UP;
+            out->key = (int32_t)e->key.keysym.sym;
+            out->mod = e->key.keysym.mod;
+            return 1;
+        default:
+            event_handle_internal(e);
+            return 0;
+    }
+}
+
+HEXLIB_API int hl_poll_event(int* out_q, int* out_r) {
+    SDL_Event e;
+    HL_Event ev;
+    while (event_next(&e)) {
+        if (!event_translate(&e, &ev) || ev.type == HL_EVENT_MOUSE_UP || ev.type == HL_EVENT_WHEEL) continue;
+        int key_event = ev.type == HL_EVENT_KEY_DOWN || ev.type == HL_EVENT_KEY_UP;
+        if (ev.type != HL_EVENT_QUIT) {
+            if (out_q) *out_q = key_event ? ev.key : ev.q;
+            if (out_r) *out_r = key_event ? 0 : ev.r;
         }
+        return ev.type;
     }
     return 0;
 }
+
+HEXLIB_API int hl_wait_event_timeout(int timeout_ms) {
+    if (!g_render_thread) {
+        if (timeout_ms < 0) return SDL_WaitEvent(NULL) == 1;
+        return SDL_WaitEventTimeout(NULL, timeout_ms) == 1;
+    }
+    // The render thread owns the pump: sleep until it reports a queued event
+    Uint32 start = SDL_GetTicks();
+    SDL_AtomicSet(&g_render_waiting, 1);
+    int ready;
+    for (;;) {
+        ready = SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT) == SDL_TRUE;
+        if (ready) break;
+        if (timeout_ms < 0) {
+            SDL_SemWait(g_render_wake);
+            continue;
+        }
+        int left = timeout_ms - (int)(SDL_GetTicks() - start);
+        if (left <= 0) break;
+        SDL_SemWaitTimeout(g_render_wake, (Uint32)left);
+    }
+    SDL_AtomicSet(&g_render_waiting, 0);
+    while (SDL_SemTryWait(g_render_wake) == 0) {}
+    return ready;
+}
+
+HEXLIB_API int hl_poll_events(HL_Event* out, int cap) {
+    if (!out || cap <= 0) return 0;
+    int n = 0;
+    SDL_Event e;
+    HL_Event ev;
+    for (;;) {
+        // Once `out` is full keep going only while motion can still merge
+        if (n == cap) {
+            if (out[n - 1].type != HL_EVENT_MOUSE_MOVE) break;
+            if (SDL_PeepEvents(&e, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) <= 0) break;
+            if (e.type != SDL_MOUSEMOTION) break;
+        }
+        if (!event_next(&e)) break;
+        if (!event_translate(&e, &ev)) continue;
+        if (ev.type == HL_EVENT_MOUSE_MOVE && n > 0 && out[n - 1].type == HL_EVENT_MOUSE_MOVE) {
+            // Coalesce: keep the latest position, remember any hex change in the run
+            ev.flags |= out[n - 1].flags & HL_EVENT_HEX_CHANGED;
+            out[n - 1] = ev;
+            continue;
+        }
+        out[n++] = ev;
+    }
+    return n;
+}
@@ -29,6 +29,7 @@ int main(void) {
     if (!hl_init(1280, 800, "HexLib (Standalone Demo)")) return 1;
     hl_set_grid(20, 28, 22.0f, 1);
     hl_set_clear_color(14, 14, 18, 255);
+    hl_set_damage_tracking(1);
     fill_demo_instances(20, 28);
 
     int running = 1;
@@ -40,7 +41,8 @@ int main(void) {
             HL_HexInstance one = { q, r, {255,255,255,255} };
             hl_set_instances(&one, 1);
         }
-        hl_step(0.0f);
+        // Nothing changed: no present and no vsync wait, so block for input
+        if (!hl_step(0.0f)) hl_wait_event_timeout(100);
     }
 
     hl_shutdown();